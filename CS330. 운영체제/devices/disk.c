@@ -7,6 +7,7 @@
 #include "threads/io.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/thread.h"
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -120,6 +121,7 @@ disk_init (void) {
 				NOT_REACHED ();
 		}
 		lock_init (&c->lock);
+		lock_set_name (&c->lock, c->name);
 		c->expecting_interrupt = false;
 		sema_init (&c->completion_wait, 0);
 
@@ -215,6 +217,7 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
 	ASSERT (buffer != NULL);
 
 	c = d->channel;
+	thread_io_begin ();
 	lock_acquire (&c->lock);
 	select_sector (d, sec_no);
 	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
@@ -223,7 +226,9 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
 		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
 	input_sector (c, buffer);
 	d->read_cnt++;
+	thread_current ()->usage.sectors_read++;
 	lock_release (&c->lock);
+	thread_io_end ();
 }
 
 /* Write sector SEC_NO to disk D from BUFFER, which must contain
@@ -239,6 +244,7 @@ disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
 	ASSERT (buffer != NULL);
 
 	c = d->channel;
+	thread_io_begin ();
 	lock_acquire (&c->lock);
 	select_sector (d, sec_no);
 	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
@@ -247,7 +253,9 @@ disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
 	output_sector (c, buffer);
 	sema_down (&c->completion_wait);
 	d->write_cnt++;
+	thread_current ()->usage.sectors_written++;
 	lock_release (&c->lock);
+	thread_io_end ();
 }
 
 /* Disk detection and identification. */
@@ -0,0 +1,352 @@
+#include "devices/hrtimer.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "intrinsic.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/mmu.h"
+#include "threads/pte.h"
+#include "threads/softirq.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* High-resolution timers.
+
+   The 8254 only interrupts TIMER_FREQ times per second, so a
+   timer_usleep() shorter than a tick used to spin in busy_wait()
+   for its whole length.  An hrtimer instead has a deadline in TSC
+   cycles, and the earliest deadline in the queue is programmed
+   into the local APIC timer, which interrupts when it is reached.
+   Expired timers run from SOFTIRQ_HRTIMER.
+
+   If the CPU has a TSC-deadline mode, the deadline is written to
+   the IA32_TSC_DEADLINE MSR as is.  Otherwise the APIC timer is
+   used in one-shot mode, with its count rate measured against the
+   TSC at boot.  Without a local APIC, hrtimers still work but are
+   only checked on every timer tick.
+
+   Only the boot processor's local APIC is used.  See [IA32-v3a]
+   10.5.4 "APIC Timer". */
+
+/* IA32_APIC_BASE and IA32_TSC_DEADLINE MSRs. */
+#define MSR_APIC_BASE 0x1b
+#define MSR_TSC_DEADLINE 0x6e0
+#define APIC_BASE_ENABLE (1 << 11)
+
+/* Local APIC registers, as offsets from its base. */
+#define LAPIC_EOI 0x0b0             /* End of interrupt. */
+#define LAPIC_SVR 0x0f0             /* Spurious interrupt vector. */
+#define LAPIC_LVT_TIMER 0x320       /* Timer local vector table entry. */
+#define LAPIC_TIMER_ICR 0x380       /* Timer initial count. */
+#define LAPIC_TIMER_CCR 0x390       /* Timer current count. */
+#define LAPIC_TIMER_DCR 0x3e0       /* Timer divide configuration. */
+
+#define LAPIC_SVR_ENABLE (1 << 8)
+#define LAPIC_LVT_MASKED (1 << 16)
+#define LAPIC_LVT_TSC_DEADLINE (2 << 17)
+#define LAPIC_DIVIDE_16 0x3
+
+/* Interrupt vectors for the APIC timer and spurious interrupts. */
+#define HRTIMER_VEC 0xf0
+#define SPURIOUS_VEC 0xff
+
+/* Timer ticks over which the TSC and APIC timer are measured. */
+#define CALIBRATE_TICKS 4
+
+/* Pending timers, earliest deadline at the top. */
+static struct heap hrtimer_queue;
+
+/* Local APIC registers, or a null pointer if there is none. */
+static volatile uint8_t *lapic;
+
+/* Use the TSC-deadline mode of the APIC timer? */
+static bool tsc_deadline;
+
+/* TSC cycles and APIC timer counts per second. */
+static uint64_t tsc_hz;
+static uint64_t lapic_hz;
+
+static heap_less_func hrtimer_later;
+static intr_handler_func hrtimer_interrupt;
+static intr_handler_func spurious_interrupt;
+static softirq_func hrtimer_softirq;
+static hrtimer_func wake_sleeper;
+static void calibrate (void);
+static void program_next (void);
+
+static uint32_t
+lapic_read (int reg) {
+	return *(volatile uint32_t *) (lapic + reg);
+}
+
+static void
+lapic_write (int reg, uint32_t val) {
+	*(volatile uint32_t *) (lapic + reg) = val;
+}
+
+/* Initializes the timer queue, measures the TSC rate and, if the
+   CPU has a local APIC, sets up its timer.  Must be called with
+   interrupts on, after timer_calibrate(). */
+void
+hrtimer_init (void) {
+	uint32_t eax = 1, ebx, ecx = 0, edx;
+
+	ASSERT (intr_get_level () == INTR_ON);
+
+	heap_init (&hrtimer_queue, hrtimer_later, NULL);
+	softirq_register (SOFTIRQ_HRTIMER, hrtimer_softirq);
+
+	/* CPUID.1: EDX[9] = APIC, ECX[24] = TSC-deadline. */
+	__asm __volatile ("cpuid"
+			: "+a" (eax), "=b" (ebx), "+c" (ecx), "=d" (edx));
+	if (edx & (1 << 9)) {
+		uint64_t base = read_msr (MSR_APIC_BASE);
+		uint64_t pa = base & ~(uint64_t) PGMASK & 0xffffffffff;
+		uint64_t *pte;
+
+		/* MMIO 페이지는 paging_init()이 매핑하지 않으므로 직접 매핑 */
+		lapic = ptov (pa);
+		pte = pml4e_walk (base_pml4, (uint64_t) lapic, 1);
+		if (pte == NULL)
+			PANIC ("hrtimer: cannot map local APIC");
+		*pte = pa | PTE_P | PTE_W | PTE_PCD;
+		invlpg ((uint64_t) lapic);
+
+		write_msr (MSR_APIC_BASE, base | APIC_BASE_ENABLE);
+		lapic_write (LAPIC_SVR, LAPIC_SVR_ENABLE | SPURIOUS_VEC);
+		lapic_write (LAPIC_TIMER_DCR, LAPIC_DIVIDE_16);
+		lapic_write (LAPIC_LVT_TIMER, LAPIC_LVT_MASKED | HRTIMER_VEC);
+		tsc_deadline = (ecx & (1 << 24)) != 0;
+	}
+	calibrate ();
+
+	if (lapic != NULL) {
+		intr_register_local (HRTIMER_VEC, hrtimer_interrupt, "APIC Timer");
+		intr_register_int (SPURIOUS_VEC, 0, INTR_OFF, spurious_interrupt,
+				"APIC Spurious");
+		lapic_write (LAPIC_LVT_TIMER, HRTIMER_VEC
+				| (tsc_deadline ? LAPIC_LVT_TSC_DEADLINE : 0));
+	}
+	printf ("hrtimer: %"PRIu64" TSC cycles/s, %s\n", tsc_hz,
+			lapic == NULL ? "tick-driven"
+			: tsc_deadline ? "APIC TSC-deadline" : "APIC one-shot");
+}
+
+/* Measures TSC_HZ and, with a local APIC, LAPIC_HZ over
+   CALIBRATE_TICKS timer ticks. */
+static void
+calibrate (void) {
+	int64_t start = timer_ticks ();
+	uint64_t tsc_start, tsc_end;
+	uint32_t counted = 0;
+
+	/* tick 경계에서부터 잼 */
+	while (timer_ticks () == start)
+		barrier ();
+	tsc_start = rdtsc ();
+	if (lapic != NULL)
+		lapic_write (LAPIC_TIMER_ICR, UINT32_MAX);
+	while (timer_ticks () - start <= CALIBRATE_TICKS)
+		barrier ();
+	tsc_end = rdtsc ();
+	if (lapic != NULL) {
+		counted = UINT32_MAX - lapic_read (LAPIC_TIMER_CCR);
+		lapic_write (LAPIC_TIMER_ICR, 0);
+	}
+
+	tsc_hz = (tsc_end - tsc_start) * TIMER_FREQ / CALIBRATE_TICKS;
+	lapic_hz = (uint64_t) counted * TIMER_FREQ / CALIBRATE_TICKS;
+	if (lapic != NULL && !tsc_deadline && lapic_hz == 0)
+		lapic = NULL;
+}
+
+/* Returns true if hrtimers expire on their own interrupt, rather
+   than only on timer ticks. */
+bool
+hrtimer_available (void) {
+	return lapic != NULL;
+}
+
+/* Called by the timer interrupt handler on every tick.  Without a
+   local APIC, this is the only chance to run expired timers. */
+void
+hrtimer_tick (void) {
+	if (lapic == NULL && tsc_hz != 0 && !heap_empty (&hrtimer_queue))
+		softirq_raise (SOFTIRQ_HRTIMER);
+}
+
+/* Initializes T to call FUNC with T, whose aux member is AUX,
+   when it expires. */
+void
+hrtimer_setup (struct hrtimer *t, hrtimer_func *func, void *aux) {
+	t->func = func;
+	t->aux = aux;
+	t->expires = 0;
+	t->queued = false;
+}
+
+/* Arms T to expire at TSC cycle EXPIRES, moving it if it is
+   already armed.  May be called from an interrupt handler. */
+void
+hrtimer_start (struct hrtimer *t, uint64_t expires) {
+	enum intr_level old_level = intr_disable ();
+
+	if (t->queued)
+		heap_remove (&hrtimer_queue, &t->elem);
+	t->expires = expires;
+	t->queued = true;
+	heap_insert (&hrtimer_queue, &t->elem);
+	if (heap_max (&hrtimer_queue) == &t->elem)
+		program_next ();
+	intr_set_level (old_level);
+}
+
+/* Disarms T.  Returns true if it was armed, false if it had
+   already expired or was never started. */
+bool
+hrtimer_cancel (struct hrtimer *t) {
+	enum intr_level old_level = intr_disable ();
+	bool queued;
+
+	queued = t->queued;
+	if (queued) {
+		bool first = heap_max (&hrtimer_queue) == &t->elem;
+
+		heap_remove (&hrtimer_queue, &t->elem);
+		t->queued = false;
+		if (first)
+			program_next ();
+	}
+	intr_set_level (old_level);
+	return queued;
+}
+
+/* Returns the current time in TSC cycles. */
+uint64_t
+hrtimer_now (void) {
+	return rdtsc ();
+}
+
+/* Converts NS nanoseconds into TSC cycles, rounding up. */
+uint64_t
+hrtimer_ns_to_cycles (int64_t ns) {
+	ASSERT (ns >= 0);
+	/* 1초 단위로 나눠서 곱셈 오버플로를 피함 */
+	return (uint64_t) (ns / 1000000000) * tsc_hz
+		+ ((uint64_t) (ns % 1000000000) * tsc_hz + 999999999) / 1000000000;
+}
+
+/* Sleeps for NS nanoseconds on an hrtimer and returns true, or
+   returns false at once if hrtimers have no interrupt of their
+   own, in which case the caller should fall back to something
+   else. */
+bool
+hrtimer_nsleep (int64_t ns) {
+	struct hrtimer timer;
+	enum intr_level old_level;
+
+	ASSERT (!intr_context ());
+	if (lapic == NULL)
+		return false;
+	if (ns <= 0)
+		return true;
+
+	hrtimer_setup (&timer, wake_sleeper, thread_current ());
+	/* 만료 콜백은 인터럽트가 켜져야 돌므로 block 전에 깨울 수 없음 */
+	old_level = intr_disable ();
+	hrtimer_start (&timer, rdtsc () + hrtimer_ns_to_cycles (ns));
+	thread_block ();
+	intr_set_level (old_level);
+	return true;
+}
+
+/* Expiry callback of hrtimer_nsleep(). */
+static void
+wake_sleeper (struct hrtimer *t) {
+	thread_unblock (t->aux);
+	thread_preempt ();
+}
+
+/* Hrtimer softirq.  Runs every expired timer, then programs the
+   APIC timer for the next one. */
+static bool
+hrtimer_softirq (void) {
+	for (;;) {
+		enum intr_level old_level = intr_disable ();
+		struct heap_elem *e;
+		struct hrtimer *t;
+
+		e = heap_max (&hrtimer_queue);
+		if (e == NULL
+				|| heap_entry (e, struct hrtimer, elem)->expires > rdtsc ()) {
+			program_next ();
+			intr_set_level (old_level);
+			return false;
+		}
+		heap_pop_max (&hrtimer_queue);
+		t = heap_entry (e, struct hrtimer, elem);
+		t->queued = false;
+		intr_set_level (old_level);
+
+		/* 콜백이 타이머를 다시 걸 수 있으므로 락 밖에서 호출 */
+		t->func (t);
+	}
+}
+
+/* Programs the APIC timer for the earliest timer in the queue, or
+   stops it if the queue is empty.  Interrupts must be off. */
+static void
+program_next (void) {
+	struct heap_elem *e = heap_max (&hrtimer_queue);
+	uint64_t expires, now, count;
+
+	if (lapic == NULL)
+		return;
+	if (e == NULL) {
+		if (tsc_deadline)
+			write_msr (MSR_TSC_DEADLINE, 0);
+		else
+			lapic_write (LAPIC_TIMER_ICR, 0);
+		return;
+	}
+
+	expires = heap_entry (e, struct hrtimer, elem)->expires;
+	if (tsc_deadline) {
+		/* 이미 지난 마감이면 곧바로 인터럽트가 옴 */
+		write_msr (MSR_TSC_DEADLINE, expires);
+		return;
+	}
+
+	/* 카운터가 32비트라 너무 먼 마감은 중간에 한 번 더 깸 */
+	now = rdtsc ();
+	count = expires > now ? expires - now : 0;
+	if (count > UINT32_MAX)
+		count = UINT32_MAX;
+	count = count * lapic_hz / tsc_hz;
+	lapic_write (LAPIC_TIMER_ICR, count == 0 ? 1
+			: count > UINT32_MAX ? UINT32_MAX : count);
+}
+
+/* Orders the timer queue so that the earliest deadline is the
+   heap's maximum. */
+static bool
+hrtimer_later (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return heap_entry (a, struct hrtimer, elem)->expires
+		> heap_entry (b, struct hrtimer, elem)->expires;
+}
+
+/* APIC timer interrupt handler. */
+static void
+hrtimer_interrupt (struct intr_frame *args UNUSED) {
+	lapic_write (LAPIC_EOI, 0);
+	softirq_raise (SOFTIRQ_HRTIMER);
+}
+
+/* Spurious APIC interrupt.  These must not be acknowledged. */
+static void
+spurious_interrupt (struct intr_frame *args UNUSED) {
+}
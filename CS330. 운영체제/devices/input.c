@@ -2,14 +2,21 @@
 #include <debug.h>
 #include "devices/intq.h"
 #include "devices/serial.h"
+#include "threads/synch.h"
 
 /* Stores keys from the keyboard and serial port. */
 static struct intq buffer;
 
+/* Number of keys in BUFFER not yet claimed by a reader.  Readers
+   wait on it rather than inside intq_getc(), so that a reader
+   whose process is exiting can be woken with sema_kill_wait(). */
+static struct semaphore keys;
+
 /* Initializes the input buffer. */
 void
 input_init (void) {
 	intq_init (&buffer);
+	sema_init (&keys, 0);
 }
 
 /* Adds a key to the input buffer.
@@ -20,13 +27,13 @@ input_putc (uint8_t key) {
 	ASSERT (!intq_full (&buffer));
 
 	intq_putc (&buffer, key);
+	sema_up (&keys);
 	serial_notify ();
 }
 
-/* Retrieves a key from the input buffer.
-   If the buffer is empty, waits for a key to be pressed. */
-uint8_t
-input_getc (void) {
+/* Takes a key, already claimed from KEYS, out of the buffer. */
+static uint8_t
+take_key (void) {
 	enum intr_level old_level;
 	uint8_t key;
 
@@ -38,6 +45,25 @@ input_getc (void) {
 	return key;
 }
 
+/* Retrieves a key from the input buffer.
+   If the buffer is empty, waits for a key to be pressed. */
+uint8_t
+input_getc (void) {
+	sema_down (&keys);
+	return take_key ();
+}
+
+/* Like input_getc(), but stores the key in *KEY and returns true,
+   or returns false without waiting any longer once the current
+   thread is marked dying (see sema_down_killable()). */
+bool
+input_getc_killable (uint8_t *key) {
+	if (!sema_down_killable (&keys))
+		return false;
+	*key = take_key ();
+	return true;
+}
+
 /* Returns true if the input buffer is full,
    false otherwise.
    Interrupts must be off. */
@@ -3,10 +3,13 @@
 #include <inttypes.h>
 #include <round.h>
 #include <stdio.h>
+#include "devices/hrtimer.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/softirq.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "threads/workqueue.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -17,32 +20,156 @@
 #error TIMER_FREQ <= 1000 recommended
 #endif
 
+/* 8254 input frequency, and PIT counts per timer tick. */
+#define PIT_HZ 1193180
+#define PIT_COUNT ((PIT_HZ + TIMER_FREQ / 2) / TIMER_FREQ)
+
+/* Longest one-shot interval the 16-bit counter can express. */
+#define ONESHOT_MAX_TICKS (0xffff / PIT_COUNT)
+
 /* Number of timer ticks since OS booted. */
 static int64_t ticks;
 
+/* -tickless: stop the periodic tick while the CPU is idle? */
+bool timer_tickless;
+
+/* Ticks covered by the armed one-shot interrupt, or 0 while the
+   timer is in periodic mode. */
+static int64_t oneshot_ticks;
+
+/* PIT counts elapsed in one-shot mode that did not add up to a
+   whole tick yet. */
+static unsigned oneshot_residue;
+
 /* Number of loops per timer tick.
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
 static intr_handler_func timer_interrupt;
+static softirq_func timer_softirq;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
+static void pit_set_periodic (void);
+static uint16_t pit_read_status (bool *expired);
+static void oneshot_stop (void);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
    corresponding interrupt. */
 void
 timer_init (void) {
+	pit_set_periodic ();
+	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
+	softirq_register (SOFTIRQ_TIMER, timer_softirq);
+}
+
+/* Programs the PIT to interrupt TIMER_FREQ times per second. */
+static void
+pit_set_periodic (void) {
 	/* 8254 input frequency divided by TIMER_FREQ, rounded to
 	   nearest. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+	uint16_t count = PIT_COUNT;
 
 	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
 	outb (0x40, count & 0xff);
 	outb (0x40, count >> 8);
+}
 
-	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
+/* Latches counter 0 with the read-back command and returns its
+   current count.  Sets *EXPIRED to the state of the OUT pin, which
+   in mode 0 goes high once the one-shot has reached zero. */
+static uint16_t
+pit_read_status (bool *expired) {
+	uint8_t status, lo, hi;
+
+	outb (0x43, 0xc2);    /* Read-back: count and status of counter 0. */
+	status = inb (0x40);
+	lo = inb (0x40);
+	hi = inb (0x40);
+	*expired = (status & 0x80) != 0;
+	return lo | (hi << 8);
+}
+
+/* Returns the number of whole ticks that have passed since the
+   one-shot was armed, storing the leftover PIT counts in *RESIDUE
+   and whether the one-shot already fired in *EXPIRED. */
+static int64_t
+oneshot_elapsed (bool *expired, unsigned *residue) {
+	uint16_t remaining = pit_read_status (expired);
+	unsigned elapsed;
+
+	if (*expired || remaining > oneshot_ticks * PIT_COUNT) {
+		*expired = true;
+		*residue = oneshot_residue;
+		return oneshot_ticks;
+	}
+	elapsed = oneshot_ticks * PIT_COUNT - remaining + oneshot_residue;
+	*residue = elapsed % PIT_COUNT;
+	return elapsed / PIT_COUNT;
+}
+
+/* Called by the idle thread, with interrupts off, right before it
+   halts.  In tickless mode, replaces the periodic tick with a single
+   interrupt at the earliest pending deadline. */
+void
+timer_idle_enter (void) {
+	int64_t deadline, due, delta;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!timer_tickless)
+		return;
+	if (oneshot_ticks != 0)
+		timer_idle_exit ();
+
+	deadline = thread_next_wakeup ();
+	/* 지연 work는 timer softirq가 큐에 넣어줘야 함 */
+	due = workqueue_next_due ();
+	if (due < deadline)
+		deadline = due;
+	/* MLFQS는 매 초 load_avg를 갱신해야 하므로 초 경계를 넘기지 않음 */
+	if (thread_mlfqs && deadline > ticks - ticks % TIMER_FREQ + TIMER_FREQ)
+		deadline = ticks - ticks % TIMER_FREQ + TIMER_FREQ;
+
+	delta = deadline - ticks;
+	if (delta <= 1)
+		return;
+	if (delta > ONESHOT_MAX_TICKS)
+		delta = ONESHOT_MAX_TICKS;
+
+	oneshot_ticks = delta;
+	outb (0x43, 0x30);    /* CW: counter 0, LSB then MSB, mode 0, binary. */
+	outb (0x40, (delta * PIT_COUNT) & 0xff);
+	outb (0x40, (delta * PIT_COUNT) >> 8);
+}
+
+/* Returns the timer to periodic mode once the CPU has work again,
+   crediting the ticks that passed while the one-shot was armed. */
+void
+timer_idle_exit (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (oneshot_ticks != 0)
+		oneshot_stop ();
+}
+
+/* Ends the armed one-shot and switches back to periodic mode.
+   If the one-shot already fired, its final tick is left to the
+   pending (or running) timer interrupt. */
+static void
+oneshot_stop (void) {
+	bool expired;
+	unsigned residue;
+	int64_t elapsed;
+
+	elapsed = oneshot_elapsed (&expired, &residue);
+	if (expired)
+		elapsed--;
+	oneshot_ticks = 0;
+	oneshot_residue = residue;
+	pit_set_periodic ();
+	ticks += elapsed;
 }
 
 /* Calibrates loops_per_tick, used to implement brief delays. */
@@ -75,6 +202,11 @@ int64_t
 timer_ticks (void) {
 	enum intr_level old_level = intr_disable ();
 	int64_t t = ticks;
+	unsigned residue;
+	bool expired;
+
+	if (oneshot_ticks != 0)
+		t += oneshot_elapsed (&expired, &residue);
 	intr_set_level (old_level);
 	barrier ();
 	return t;
@@ -122,29 +254,51 @@ timer_print_stats (void) {
 	printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
 }
 
-/* Timer interrupt handler. */
+/* Timer interrupt handler.  Only the per-tick accounting of the
+   running thread is done here; the rest is left to
+   timer_softirq(). */
 static void
-timer_interrupt (struct intr_frame *args UNUSED) {
+timer_interrupt (struct intr_frame *args) {
+	/* Tickless 모드의 one-shot이 끝났거나 그 전에 걸려있던 tick */
+	if (oneshot_ticks != 0)
+		oneshot_stop ();
 	ticks++;
-	thread_tick ();
-
-	/* [P1-1] 스레드 깨우기 */
-	int flag = thread_wakeup(ticks);
+	thread_tick (args);
 
-	/* [P1-3] MLFQS 기반 변수 업데이트 */
+	/* [P1-3] 실행 중인 스레드의 recent_cpu와 4 tick마다 priority 갱신 */
 	if(thread_mlfqs){
 		add_recent_cpu();
-		if(ticks % TIMER_FREQ == 0){
-			recalculate_load_avg();
-			recalculate_recent_cpu();
-		}
-		if(ticks % 4 == 0)
+		if(ticks % TIMER_FREQ != 0 && ticks % 4 == 0)
 		  	recalculate_priority();
 	}
 
-	/* jds: interrupt 도중에 preempt 부르면 yield에서 에러 발생 => yield on return 호출 */
-	/* 		flag는 필요없을 것 같음 */
-	if(flag) intr_yield_on_return();
+	/* 스레드 깨우기와 매 초 전체 갱신은 인터럽트를 켠 뒤에 */
+	softirq_raise (SOFTIRQ_TIMER);
+	hrtimer_tick ();
+}
+
+/* Timer softirq.  Wakes up the sleeping threads and queues the
+   delayed works that are due and, with MLFQS, recomputes load_avg
+   and every thread's recent_cpu once per second.  Several ticks
+   may be handled at once if the softirq was delayed. */
+static bool
+timer_softirq (void) {
+	static int64_t last_second;     /* Last second MLFQS was updated. */
+	int64_t now = timer_ticks ();
+
+	/* [P1-1] 스레드 깨우기 */
+	bool flag = thread_wakeup(now);
+
+	/* 시간이 된 지연 work를 큐로 */
+	workqueue_timer (now);
+
+	/* [P1-3] 매 초 load_avg와 전체 스레드의 recent_cpu 갱신 */
+	if(thread_mlfqs && now / TIMER_FREQ != last_second){
+		last_second = now / TIMER_FREQ;
+		recalculate_load_avg();
+		recalculate_recent_cpu();
+	}
+	return flag;
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -195,10 +349,11 @@ real_time_sleep (int64_t num, int32_t denom) {
 		   timer_sleep() because it will yield the CPU to other
 		   processes. */
 		timer_sleep (ticks);
-	} else {
-		/* Otherwise, use a busy-wait loop for more accurate
-		   sub-tick timing.  We scale the numerator and denominator
-		   down by 1000 to avoid the possibility of overflow. */
+	} else if (!hrtimer_nsleep (num * (1000 * 1000 * 1000 / denom))) {
+		/* Otherwise, sleep on a high-resolution timer, or if there
+		   is none, use a busy-wait loop for more accurate sub-tick
+		   timing.  We scale the numerator and denominator down by
+		   1000 to avoid the possibility of overflow. */
 		ASSERT (denom % 1000 == 0);
 		busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
 	}
@@ -5,6 +5,7 @@
 #include "filesys/filesys.h"
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
 #include "threads/thread.h"
 #include "filesys/fat.h"
 
@@ -21,6 +22,15 @@ struct dir_entry {
 	bool in_use;                        /* In use or free? */
 };
 
+/* Cache of struct dir. */
+static struct kmem_cache *dir_cache;
+
+/* Initializes the directory module. */
+void
+dir_init (void) {
+	dir_cache = kmem_cache_create ("dir", sizeof (struct dir), 0, NULL);
+}
+
 /* Creates a directory with space for ENTRY_CNT entries in the
  * given SECTOR.  Returns true if successful, false on failure. */
 bool
@@ -32,7 +42,7 @@ dir_create (disk_sector_t sector, size_t entry_cnt) {
  * it takes ownership.  Returns a null pointer on failure. */
 struct dir *
 dir_open (struct inode *inode) {
-	struct dir *dir = calloc (1, sizeof *dir);
+	struct dir *dir = kmem_cache_zalloc (dir_cache);
 	if (inode != NULL && dir != NULL) {
 		// msg("[dir open] open %d", inode_get_inumber(inode));
 		dir->inode = inode;
@@ -40,7 +50,7 @@ dir_open (struct inode *inode) {
 		return dir;
 	} else {
 		inode_close (inode);
-		free (dir);
+		kmem_cache_free (dir_cache, dir);
 		return NULL;
 	}
 }
@@ -92,7 +102,7 @@ dir_close (struct dir *dir) {
 	// msg("[dir close] close %d", inode_get_inumber(dir->inode));
 	if (dir != NULL) {
 		inode_close (dir->inode);
-		free (dir);
+		kmem_cache_free (dir_cache, dir);
 	}
 }
 
@@ -37,6 +37,11 @@ fat_init (void) {
 	if (fat_fs == NULL)
 		PANIC ("FAT init failed");
 
+	/* format 시 fat_fs_init()이 두 번 불리므로 lock은 여기서 한 번만 초기화.
+	   두 번 초기화하면 lock_set_name()의 통계 목록에 두 번 걸림 */
+	lock_init(&fat_fs->write_lock);
+	lock_set_name(&fat_fs->write_lock, "fat write_lock");
+
 	// Read boot sector from the disk
 	unsigned int *bounce = malloc (DISK_SECTOR_SIZE);
 	if (bounce == NULL)
@@ -157,9 +162,6 @@ fat_fs_init (void) {
 	fat_fs->fat_length = disk_size(filesys_disk) - fat_fs->bs.fat_sectors - 1; // [P4-1] FAT에 저장할 수 있는 전체 클러스터 수 (섹터 수 * FAT 엔트리 수)
 	//fat_fs->fat_length = fat_fs->bs.fat_sectors * DISK_SECTOR_SIZE / sizeof(cluster_t); // [P4-1] FAT에 저장할 수 있는 전체 클러스터 수 (섹터 수 * FAT 엔트리 수) 
 	fat_fs->data_start = fat_fs->bs.fat_sectors + fat_fs->bs.fat_start; // [P4-1] 파일 데이터가 시작되는 첫 섹터 번호 (FAT 영역 크기 + FAT 시작)
-	
-
-	lock_init(&fat_fs->write_lock); // [P4-1] FAT 쓰기 동기화를 위해 lock 초기화
 }
 
 /*----------------------------------------------------------------------------*/
@@ -2,26 +2,39 @@
 #include <debug.h>
 #include "filesys/inode.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/synch.h"
 
 /* An open file. */
 struct file {
 	struct inode *inode;        /* File's inode. */
 	off_t pos;                  /* Current position. */
+	struct lock pos_lock;       /* Protects pos and the position of dir. */
 	bool deny_write;            /* Has file_deny_write() been called? */
 #ifdef EFILESYS
 	struct dir *dir;			/* [P4-2]  dir를 가리키는 file이면 해당 dir 넣어둠 */
 #endif
 };
 
+/* Cache of struct file. */
+static struct kmem_cache *file_cache;
+
+/* Initializes the file module. */
+void
+file_init (void) {
+	file_cache = kmem_cache_create ("file", sizeof (struct file), 0, NULL);
+}
+
 /* Opens a file for the given INODE, of which it takes ownership,
  * and returns the new file.  Returns a null pointer if an
  * allocation fails or if INODE is null. */
 struct file *
 file_open (struct inode *inode) {
-	struct file *file = calloc (1, sizeof *file);
+	struct file *file = kmem_cache_zalloc (file_cache);
 	if (inode != NULL && file != NULL) {
 		file->inode = inode;
 		file->pos = 0;
+		lock_init (&file->pos_lock);
 		file->deny_write = false;
 #ifdef EFILESYS
 	if(inode_is_dir(inode))
@@ -32,7 +45,7 @@ file_open (struct inode *inode) {
 		return file;
 	} else {
 		inode_close (inode);
-		free (file);
+		kmem_cache_free (file_cache, file);
 		return NULL;
 	}
 }
@@ -50,7 +63,9 @@ struct file *
 file_duplicate (struct file *file) {
 	struct file *nfile = file_open (inode_reopen (file->inode));
 	if (nfile) {
+		lock_acquire (&file->pos_lock);
 		nfile->pos = file->pos;
+		lock_release (&file->pos_lock);
 		if (file->deny_write)
 			file_deny_write (nfile);
 	}
@@ -67,7 +82,7 @@ file_close (struct file *file) {
 		}
 		file_allow_write (file);
 		inode_close (file->inode);
-		free (file);
+		kmem_cache_free (file_cache, file);
 	}
 }
 
@@ -84,8 +99,12 @@ file_get_inode (struct file *file) {
  * Advances FILE's position by the number of bytes read. */
 off_t
 file_read (struct file *file, void *buffer, off_t size) {
-	off_t bytes_read = inode_read_at (file->inode, buffer, size, file->pos);
+	off_t bytes_read;
+
+	lock_acquire (&file->pos_lock);
+	bytes_read = inode_read_at (file->inode, buffer, size, file->pos);
 	file->pos += bytes_read;
+	lock_release (&file->pos_lock);
 	return bytes_read;
 }
 
@@ -109,8 +128,12 @@ file_read_at (struct file *file, void *buffer, off_t size, off_t file_ofs) {
 off_t
 file_write (struct file *file, const void *buffer, off_t size) {
 	// msg("[file_write] write at %d", inode_get_inumber(file->inode));
-	off_t bytes_written = inode_write_at (file->inode, buffer, size, file->pos);
+	off_t bytes_written;
+
+	lock_acquire (&file->pos_lock);
+	bytes_written = inode_write_at (file->inode, buffer, size, file->pos);
 	file->pos += bytes_written;
+	lock_release (&file->pos_lock);
 	return bytes_written;
 }
 
@@ -164,7 +187,9 @@ void
 file_seek (struct file *file, off_t new_pos) {
 	ASSERT (file != NULL);
 	ASSERT (new_pos >= 0);
+	lock_acquire (&file->pos_lock);
 	file->pos = new_pos;
+	lock_release (&file->pos_lock);
 }
 
 /* Returns the current position in FILE as a byte offset from the
@@ -175,6 +200,22 @@ file_tell (struct file *file) {
 	return file->pos;
 }
 
+/* Locks FILE's position, and that of its directory if it is one,
+ * against file_read(), file_write() and file_seek() on FILE from
+ * other threads, until file_unlock_pos(). */
+void
+file_lock_pos (struct file *file) {
+	ASSERT (file != NULL);
+	lock_acquire (&file->pos_lock);
+}
+
+/* Releases the lock taken by file_lock_pos(). */
+void
+file_unlock_pos (struct file *file) {
+	ASSERT (file != NULL);
+	lock_release (&file->pos_lock);
+}
+
 struct dir* 
 file_get_dir(struct file *file){
 	if(file == NULL) 
@@ -8,7 +8,9 @@
 #include "filesys/directory.h"
 #include "devices/disk.h"
 #include "filesys/fat.h"
+#include "threads/interrupt.h"
 #include "threads/malloc.h"
+#include "threads/workqueue.h"
 #include "lib/string.h"
 
 /* The disk that contains the file system. */
@@ -25,6 +27,8 @@ filesys_init (bool format) {
 		PANIC ("hd0:1 (hdb) not present, file system initialization failed");
 
 	inode_init ();
+	file_init ();
+	dir_init ();
 
 #ifdef EFILESYS
 	fat_init ();
@@ -51,6 +55,10 @@ filesys_init (bool format) {
  * to disk. */
 void
 filesys_done (void) {
+	/* 지운 파일의 블록 해제가 끝난 뒤에 디스크에 기록 (panic 중에는 생략) */
+	if (intr_get_level () == INTR_ON)
+		flush_workqueue (system_wq);
+
 	/* Original FS */
 #ifdef EFILESYS
 	fat_close ();
@@ -385,16 +393,22 @@ bool filesys_read_dir(struct file* file, char* name){
 		return false;
 
 	struct dir* dir = file_get_dir(file);
+	bool found = false;
 	// msg("[filesys read dir] dir: %d", inode_get_inumber(inode));
 
+	/* 같은 fd로 readdir하는 다른 스레드와 dir->pos를 나눠 쓰지 않도록 */
+	file_lock_pos(file);
     while (dir_readdir(dir, name)) {
-        if (strcmp(name, ".") != 0 && strcmp(name, "..") != 0)
-            return true;  // 유효한 항목 발견
+        if (strcmp(name, ".") != 0 && strcmp(name, "..") != 0) {
+            found = true;  // 유효한 항목 발견
+            break;
+        }
         // 아니라면 loop 계속 → dir->pos는 자연히 증가
     }
+	file_unlock_pos(file);
 
 	// msg("[filesys read dir] return false");
-	return false;
+	return found;
 }
 
 int filesys_inumber(struct file* file){
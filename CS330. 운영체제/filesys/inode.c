@@ -6,6 +6,8 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#include "threads/slab.h"
+#include "threads/workqueue.h"
 #include "filesys/fat.h" // [P4-1] FAT 기반 구현
 #include "lib/string.h"
 
@@ -47,6 +49,7 @@ struct inode {
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
 	struct inode_disk data;             /* Inode content. */
+	struct work free_work;              /* Frees the blocks once removed. */
 };
 
 /* Returns the disk sector that contains byte offset POS within
@@ -84,10 +87,16 @@ byte_to_sector (const struct inode *inode, off_t pos) {
  * returns the same `struct inode'. */
 static struct list open_inodes;
 
+/* Cache of struct inode. */
+static struct kmem_cache *inode_cache;
+
+static void inode_free (void *inode_);
+
 /* Initializes the inode module. */
 void
 inode_init (void) {
 	list_init (&open_inodes);
+	inode_cache = kmem_cache_create ("inode", sizeof (struct inode), 0, NULL);
 }
 
 /* Initializes an inode with LENGTH bytes of data and
@@ -189,7 +198,7 @@ inode_open (disk_sector_t sector) {
 	}
 
 	/* Allocate memory. */
-	inode = malloc (sizeof *inode);
+	inode = kmem_cache_alloc (inode_cache);
 	if (inode == NULL)
 		return NULL;
 
@@ -235,24 +244,32 @@ inode_close (struct inode *inode) {
 		/* Remove from inode list and release lock. */
 		list_remove (&inode->elem);
 
-#ifndef EFILESYS
-		/* Deallocate blocks if removed. */
+		/* 지운 파일의 블록 해제는 디스크 I/O가 있으므로 system_wq에서 */
 		if (inode->removed) {
-			free_map_release (inode->sector, 1);
-			free_map_release (inode->data.start,
-					bytes_to_sectors (inode->data.length)); 
-		}
+			work_init (&inode->free_work, inode_free, inode);
+			schedule_work (&inode->free_work);
+		} else
+			kmem_cache_free (inode_cache, inode);
+	}
+}
+
+/* Releases the blocks of INODE_, a removed inode that nobody has
+ * open, and frees it.  Runs on system_wq for inode_close(). */
+static void
+inode_free (void *inode_) {
+	struct inode *inode = inode_;
+
+#ifndef EFILESYS
+	free_map_release (inode->sector, 1);
+	free_map_release (inode->data.start,
+			bytes_to_sectors (inode->data.length));
 #else // [P4-1] FAT 기반 구현
-		if(inode->removed){
-			// free_map_release (inode->sector, 1);
-			cluster_t clst = inode->data.start; // [P4-1]
-			if (clst != 0) fat_remove_chain(clst, 0); // [P4-1]
-			//TODO: fat_remove_chain(inode->sector, 0) ?
-		}	
+	// free_map_release (inode->sector, 1);
+	cluster_t clst = inode->data.start; // [P4-1]
+	if (clst != 0) fat_remove_chain(clst, 0); // [P4-1]
+	//TODO: fat_remove_chain(inode->sector, 0) ?
 #endif
-
-		free (inode); 
-	}
+	kmem_cache_free (inode_cache, inode);
 }
 
 /* Marks INODE to be deleted when it is closed by the last caller who
@@ -0,0 +1,37 @@
+#ifndef DEVICES_HRTIMER_H
+#define DEVICES_HRTIMER_H
+
+#include <heap.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* High-resolution timers.  See devices/hrtimer.c. */
+
+struct hrtimer;
+
+/* Called when an hrtimer expires.  Runs in softirq context, with
+   interrupts on, so it must not sleep. */
+typedef void hrtimer_func (struct hrtimer *);
+
+/* A one-shot timer with a deadline in TSC cycles. */
+struct hrtimer {
+	struct heap_elem elem;      /* Element in the timer queue. */
+	uint64_t expires;           /* Absolute TSC deadline. */
+	hrtimer_func *func;         /* Expiry callback. */
+	void *aux;                  /* Data for FUNC. */
+	bool queued;                /* In the timer queue? */
+};
+
+void hrtimer_init (void);
+bool hrtimer_available (void);
+void hrtimer_tick (void);
+
+void hrtimer_setup (struct hrtimer *, hrtimer_func *, void *aux);
+void hrtimer_start (struct hrtimer *, uint64_t expires);
+bool hrtimer_cancel (struct hrtimer *);
+
+uint64_t hrtimer_now (void);
+uint64_t hrtimer_ns_to_cycles (int64_t ns);
+bool hrtimer_nsleep (int64_t ns);
+
+#endif /* devices/hrtimer.h */
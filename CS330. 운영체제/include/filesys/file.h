@@ -12,6 +12,7 @@
 struct inode;
 
 /* Opening and closing files. */
+void file_init (void);
 struct file *file_open (struct inode *);
 struct file *file_reopen (struct file *);
 struct file *file_duplicate (struct file *file);
@@ -32,6 +33,8 @@ void file_allow_write (struct file *);
 void file_seek (struct file *, off_t);
 off_t file_tell (struct file *);
 off_t file_length (struct file *);
+void file_lock_pos (struct file *);
+void file_unlock_pos (struct file *);
 
 /*[P4-2]*/
 struct dir* file_get_dir(struct file*);
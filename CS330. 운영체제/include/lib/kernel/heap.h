@@ -0,0 +1,65 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Max-heap (priority queue).
+ *
+ * This is a pairing heap: a multiway tree in which every element
+ * is no less than its children, kept as a leftmost-child /
+ * next-sibling binary tree.  Inserting an element and reading
+ * the maximum are O(1); removing the maximum or an arbitrary
+ * element is O(log n) amortized.  An element whose key changed,
+ * in either direction, is repositioned with heap_update().
+ *
+ * Like lists and hash tables, heaps do not use dynamic
+ * allocation.  Each structure that can be in a heap embeds a
+ * struct heap_elem member, and heap_entry() converts a pointer to
+ * that member back into a pointer to the containing structure.
+ * Refer to lib/kernel/list.h for a detailed explanation. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem {
+	struct heap_elem *child;    /* Leftmost child. */
+	struct heap_elem *next;     /* Next sibling. */
+	struct heap_elem *prev;     /* Previous sibling, or parent of
+	                               a leftmost child. */
+};
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+ * the structure that HEAP_ELEM is embedded inside.  Supply the
+ * name of the outer structure STRUCT and the member name MEMBER
+ * of the heap element. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)           \
+	((STRUCT *) ((uint8_t *) (HEAP_ELEM)            \
+		- offsetof (STRUCT, MEMBER)))
+
+/* Compares the value of two heap elements A and B, given
+ * auxiliary data AUX.  Returns true if A is less than B, or
+ * false if A is greater than or equal to B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+		const struct heap_elem *b,
+		void *aux);
+
+/* Heap. */
+struct heap {
+	struct heap_elem *root;     /* Maximum element, or NULL. */
+	size_t elem_cnt;            /* Number of elements in heap. */
+	heap_less_func *less;       /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+
+void heap_insert (struct heap *, struct heap_elem *);
+struct heap_elem *heap_max (const struct heap *);
+struct heap_elem *heap_pop_max (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+void heap_update (struct heap *, struct heap_elem *);
+
+size_t heap_size (const struct heap *);
+bool heap_empty (const struct heap *);
+
+#endif /* lib/kernel/heap.h */
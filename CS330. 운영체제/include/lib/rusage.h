@@ -0,0 +1,18 @@
+#ifndef __LIB_RUSAGE_H
+#define __LIB_RUSAGE_H
+
+/* Resource usage, as reported by the getrusage() system call. */
+struct rusage {
+	long long user_ticks;           /* Timer ticks in user mode. */
+	long long kernel_ticks;         /* Timer ticks in the kernel. */
+	long long voluntary_switches;   /* Context switches by blocking. */
+	long long involuntary_switches; /* Context switches by preemption. */
+	long long sectors_read;         /* Disk sectors read. */
+	long long sectors_written;      /* Disk sectors written. */
+};
+
+/* Whose usage getrusage() reports. */
+#define RUSAGE_SELF 0               /* The calling process. */
+#define RUSAGE_CHILDREN (-1)        /* Its children that were waited for. */
+
+#endif /* lib/rusage.h */
@@ -36,6 +36,18 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Scheduling. */
+	SYS_SCHED_DEADLINE,         /* Enter or leave the EDF class. */
+	SYS_GETRUSAGE,              /* Report resource usage. */
+
+	/* Synchronization. */
+	SYS_FUTEX_WAIT,             /* Sleep on a futex. */
+	SYS_FUTEX_WAKE,             /* Wake threads sleeping on a futex. */
+
+	/* Threads. */
+	SYS_CLONE,                  /* Start a thread in this process. */
+	SYS_JOIN,                   /* Wait for a thread to exit. */
 };
 
 #endif /* lib/syscall-nr.h */
@@ -0,0 +1,40 @@
+#ifndef __LIB_USER_SYNC_H
+#define __LIB_USER_SYNC_H
+
+#include <stdbool.h>
+
+/* Mutexes and condition variables for user programs.
+
+   Both keep their whole state in an int that is changed with
+   atomic instructions, and only call futex_wait() or
+   futex_wake() when a thread has to sleep or be woken, so
+   locking and unlocking a mutex nobody else wants never enters
+   the kernel.  They work between the threads of one process
+   only: file mappings are not shared between processes. */
+
+/* Mutex. */
+struct mutex {
+	int state;                  /* 0: unlocked, 1: locked,
+	                               2: locked, maybe with waiters. */
+};
+
+#define MUTEX_INITIALIZER { 0 }
+
+void mutex_init (struct mutex *);
+void mutex_lock (struct mutex *);
+bool mutex_trylock (struct mutex *);
+void mutex_unlock (struct mutex *);
+
+/* Condition variable. */
+struct condvar {
+	int seq;                    /* Bumped by every signal. */
+};
+
+#define CONDVAR_INITIALIZER { 0 }
+
+void condvar_init (struct condvar *);
+void condvar_wait (struct condvar *, struct mutex *);
+void condvar_signal (struct condvar *);
+void condvar_broadcast (struct condvar *);
+
+#endif /* lib/user/sync.h */
@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <rusage.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -50,6 +51,21 @@ bool isdir (int fd);
 int inumber (int fd);
 int symlink (const char* target, const char* linkpath);
 
+/* Scheduling. */
+int sched_deadline (unsigned runtime, unsigned deadline, unsigned period);
+int getrusage (int who, struct rusage *usage);
+
+/* Synchronization.  See lib/user/sync.h for locks built on these. */
+int futex_wait (int *uaddr, int val);
+int futex_wake (int *uaddr, int cnt);
+
+/* Threads that share the address space and file descriptors of
+   their process.  The new thread runs FUNC (AUX) on STACK, which
+   points just past the end of memory the caller set aside for it,
+   and FUNC's return value becomes its exit status. */
+pid_t clone (int (*func) (void *), void *aux, void *stack);
+int join (pid_t tid);
+
 static inline void* get_phys_addr (void *user_addr) {
 	void* pa;
 	asm volatile ("movq %0, %%rax" ::"r"(user_addr));
@@ -0,0 +1,59 @@
+#ifndef THREADS_SCHED_TRACE_H
+#define THREADS_SCHED_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct thread;
+
+/* Scheduler events. */
+enum sched_event_type {
+	SCHED_SWITCH_IN,        /* Thread starts running. */
+	SCHED_SWITCH_OUT,       /* Thread stops running. */
+	SCHED_BLOCK,            /* thread_block(). */
+	SCHED_UNBLOCK,          /* thread_unblock(). */
+	SCHED_DONATE,           /* Thread receives a donated priority. */
+	SCHED_SLEEP,            /* thread_sleep(). */
+	SCHED_WAKEUP,           /* Sleeping thread is due. */
+	SCHED_EVENT_CNT
+};
+
+/* One recorded event. */
+struct sched_event {
+	uint64_t tsc;           /* Time stamp counter when recorded. */
+	int32_t tid;            /* Thread the event is about. */
+	uint16_t type;          /* enum sched_event_type. */
+	int16_t priority;       /* Thread's priority afterward. */
+};
+
+/* Number of events kept.  Must be a power of 2. */
+#define SCHED_TRACE_SIZE 256
+
+/* Histogram bucket B counts latencies in [2**B, 2**(B+1)) cycles. */
+#define SCHED_HIST_BUCKETS 48
+
+/* Trace state: the ring buffer and the latency histograms. */
+struct sched_trace {
+	struct sched_event ring[SCHED_TRACE_SIZE];
+	uint64_t head;                      /* # of events ever recorded. */
+	uint64_t wakeup_hist[SCHED_HIST_BUCKETS];  /* Unblock to run. */
+	uint64_t runq_hist[SCHED_HIST_BUCKETS];    /* Ready to run. */
+};
+
+/* -sched-trace: record scheduler events? */
+extern bool sched_trace_enabled;
+
+void sched_trace_init (void);
+void sched_trace_record (enum sched_event_type, struct thread *);
+void sched_trace_print_stats (void);
+void sched_trace_dump (void);
+
+/* Records event TYPE about thread T, if tracing is enabled.
+   Must be called with interrupts off. */
+static inline void
+sched_trace (enum sched_event_type type, struct thread *t) {
+	if (sched_trace_enabled)
+		sched_trace_record (type, t);
+}
+
+#endif /* threads/sched-trace.h */
@@ -0,0 +1,22 @@
+#ifndef THREADS_SLAB_H
+#define THREADS_SLAB_H
+
+#include <stddef.h>
+
+/* Object caches.  See threads/slab.c. */
+
+struct kmem_cache;
+
+/* Constructor run on each object of a new slab. */
+typedef void kmem_ctor_func (void *obj);
+
+struct kmem_cache *kmem_cache_create (const char *name, size_t size,
+		size_t align, kmem_ctor_func *);
+void *kmem_cache_alloc (struct kmem_cache *);
+void *kmem_cache_zalloc (struct kmem_cache *);
+void kmem_cache_free (struct kmem_cache *, void *);
+size_t kmem_cache_reclaim (struct kmem_cache *);
+
+void kmem_cache_print_stats (void);
+
+#endif /* threads/slab.h */
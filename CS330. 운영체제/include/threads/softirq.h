@@ -0,0 +1,27 @@
+#ifndef THREADS_SOFTIRQ_H
+#define THREADS_SOFTIRQ_H
+
+#include <stdbool.h>
+
+/* Deferred interrupt work ("softirqs").  See threads/softirq.c. */
+
+/* Softirq numbers, run in this order. */
+enum softirq_nr {
+	SOFTIRQ_HRTIMER,        /* Expired high-resolution timers. */
+	SOFTIRQ_TIMER,          /* Sleeper wakeups, MLFQS bookkeeping. */
+	SOFTIRQ_CNT
+};
+
+/* A softirq handler.  Runs with interrupts on but must not sleep.
+   Returns true if the current thread should yield once all
+   pending softirqs have run; thread_preempt() takes care of that
+   by itself. */
+typedef bool softirq_func (void);
+
+void softirq_init (void);
+void softirq_register (enum softirq_nr, softirq_func *);
+void softirq_raise (enum softirq_nr);
+bool softirq_run (bool yield);
+bool softirq_yield_on_return (void);
+
+#endif /* threads/softirq.h */
@@ -0,0 +1,18 @@
+#ifndef THREADS_SWITCH_H
+#define THREADS_SWITCH_H
+
+#ifndef __ASSEMBLER__
+#include <stdint.h>
+
+struct intr_frame;
+
+/* Switches to a kernel thread whose context was saved by one of
+   these functions, saving the current one into *CUR_RSP. */
+void switch_to (uint64_t *cur_rsp, uint64_t next_rsp);
+
+/* Saves the current kernel thread into *CUR_RSP and launches a
+   thread that has never run from its interrupt frame TF. */
+void switch_to_iret (uint64_t *cur_rsp, struct intr_frame *tf);
+#endif
+
+#endif /* threads/switch.h */
@@ -1,37 +1,88 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
+
+struct thread;
 
 /* A counting semaphore. */
 struct semaphore {
 	unsigned value;             /* Current value. */
-	struct list waiters;        /* List of waiting threads. */
+	struct heap waiters;        /* Waiting threads, highest priority first. */
 };
 
 void sema_init (struct semaphore *, unsigned value);
 void sema_down (struct semaphore *);
+bool sema_down_killable (struct semaphore *);
+void sema_kill_wait (struct thread *);
 bool sema_try_down (struct semaphore *);
 void sema_up (struct semaphore *);
 void sema_self_test (void);
 
+/* Contention statistics of a named lock, in time stamp counter
+   cycles. */
+struct lock_stat {
+	const char *kind;           /* "Lock", "RWLock read" or "RWLock write". */
+	const char *name;           /* Name given to the lock. */
+	uint64_t acquire_tsc;       /* When the holder acquired it. */
+	uint64_t acquired;          /* # of acquisitions. */
+	uint64_t contended;         /* # of acquisitions that had to wait. */
+	uint64_t wait_cycles;       /* Total time spent waiting. */
+	uint64_t wait_max;          /* Longest wait. */
+	uint64_t hold_cycles;       /* Total time held. */
+	uint64_t hold_max;          /* Longest hold. */
+};
+
+/* Priority donated to a thread through something it holds that
+   other threads wait for: a lock, or its read side of a
+   readers-writer lock. */
+struct donation {
+	int priority;               /* Highest priority among waiters. */
+	struct heap_elem elem;      /* Element in holder's held_locks. */
+};
+
 /* Lock. */
 struct lock {
 	struct thread *holder;      /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+	struct donation donation;   /* Donated to the holder by waiters. */
+	struct lock_stat *stat;     /* Statistics, or NULL if not named. */
 };
 
 /* [P1-2] 헤더 파일 선언 */
-void donate_priority(void);
-bool compare_donation_priority(const struct list_elem *a, const struct list_elem *b, void *aux);
-void rollback_priority(void);
+bool lock_priority_less(const struct heap_elem *a, const struct heap_elem *b, void *aux);
+void refresh_priority(void);
 
 void lock_init (struct lock *);
 void lock_acquire (struct lock *);
 bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
+void lock_set_name (struct lock *, const char *name);
+void lock_print_stats (void);
+
+/* Readers-writer lock.  Any number of readers, or one writer.
+   A thread may hold at most one readers-writer lock for reading
+   at a time. */
+struct rwlock {
+	struct lock lock;           /* Held by the writer. */
+	struct list readers;        /* Threads holding it for reading. */
+	struct semaphore drained;   /* Upped when the last reader leaves. */
+	int drain_waiters;          /* # of writers waiting on drained. */
+	bool prefer_writers;        /* Hold off new readers for writers? */
+	struct lock_stat *read_stat; /* Statistics, or NULL if not named. */
+	struct lock_stat *write_stat;
+};
+
+void rwlock_init (struct rwlock *, bool prefer_writers);
+void rwlock_read_acquire (struct rwlock *);
+void rwlock_write_acquire (struct rwlock *);
+void rwlock_release (struct rwlock *);
+bool rwlock_held_by_current_thread (const struct rwlock *);
+void rwlock_set_name (struct rwlock *, const char *name);
 
 /* Condition variable. */
 struct condition {
@@ -2,7 +2,9 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <hash.h>
 #include <list.h>
+#include <rusage.h>
 #include <stdint.h>
 #include "threads/interrupt.h"
 #include "threads/synch.h" // P2. semaphore 구조체 사용
@@ -89,11 +91,11 @@ typedef int tid_t;
  * set to THREAD_MAGIC.  Stack overflow will normally change this
  * value, triggering the assertion. */
 /* The `elem' member has a dual purpose.  It can be an element in
- * the run queue (thread.c), or it can be an element in a
- * semaphore wait list (synch.c).  It can be used these two ways
- * only because they are mutually exclusive: only a thread in the
- * ready state is on the run queue, whereas only a thread in the
- * blocked state is on a semaphore wait list. */
+ * the run queue (thread.c), or it can be an element in a sleep
+ * bucket (thread.c).  It can be used these two ways only because
+ * they are mutually exclusive: only a thread in the ready state is
+ * on the run queue, whereas only a blocked thread is asleep.
+ * Semaphore waiters are kept in a heap through `wait_elem'. */
 struct thread {
 	/* Owned by thread.c. */
 	tid_t tid;                          /* Thread identifier. */
@@ -104,17 +106,33 @@ struct thread {
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem;              /* List element. */
 
+	/* Owned by sched-trace.c. */
+	uint64_t ready_tsc;                 /* TSC when T became ready, or 0. */
+	bool ready_woken;                   /* Became ready by thread_unblock()? */
+
 	/* [P1-1] 깨어날 시간 값 */
 	int64_t wakeup_tick;
 
+	/* Owned by synch.c. */
+	struct heap_elem wait_elem;         /* Element in semaphore waiters. */
+	struct semaphore *waiting_sema;     /* Semaphore being waited on. */
+	uint64_t wait_seq;                  /* FIFO order among equal priorities. */
+	bool wait_killable;                 /* In sema_down_killable(). */
+
 	/* [P1-2] 다른 스레드 점유가 해제되기를 기다리고 있는 lock */
 	struct lock *waiting_lock;
 
-	/* [P1-2] 우선순위를 기부해준 스레드들의 연결 리스트 */
-	struct list donations;
+	/* [P1-2] 보유 중인 lock들, 기부받은 우선순위가 높은 순 */
+	struct heap held_locks;
 
-	/* [P1-2] 다른 스레드에게 우선순위를 기부할 때 donations에 넣을 elem */
-	struct list_elem donation_elem;
+	/* 읽기로 보유 중인 rwlock과, writer가 그 reader에게 하는 기부 */
+	struct rwlock *reading;
+	struct donation read_hold;
+	struct list_elem reader_elem;       /* Element in rwlock readers. */
+	uint64_t read_tsc;                  /* When READING was acquired. */
+
+	/* writer로서 reader들이 나가기를 기다리는 rwlock */
+	struct rwlock *draining;
 
 	/* [P1-2] 스레드 생성 시 받았던 최초의 우선순위 */
 	int init_priority; 
@@ -124,6 +142,37 @@ struct thread {
 	int recent_cpu;
 	struct list_elem allelem;   
 
+	/* 적응형 time slice에 필요한 값 */
+	int sleep_avg;                      /* Recent ticks blocked minus run. */
+	int64_t block_tick;                 /* When T last blocked. */
+	bool boosted;                       /* Queued ahead as I/O-bound? */
+
+	/* 디스크 I/O 완료로 깨어난 스레드의 일시적 가산점 */
+	bool io_wait;                       /* Blocking waits are for I/O? */
+	int io_boost;                       /* Ticks of I/O wakeup boost left. */
+
+	/* -cfs 스케줄링에 필요한 값 */
+	uint64_t vruntime;                  /* Weighted run time. */
+	int cfs_weight;                     /* Weight while in cfs_queue. */
+	struct heap_elem cfs_elem;          /* Element in cfs_queue. */
+
+	/* EDF 실시간 클래스에 필요한 값 (tick 단위), edf_runtime이 0이면 일반 스레드 */
+	int64_t edf_runtime;                /* Budget per period. */
+	int64_t edf_deadline;               /* Deadline relative to period start. */
+	int64_t edf_period;                 /* Period. */
+	int64_t edf_period_start;           /* Start of the current period. */
+	int64_t edf_abs_deadline;           /* Deadline of the current period. */
+	int64_t edf_budget;                 /* Budget left in this period. */
+	bool edf_throttled;                 /* Waiting on edf_throttled? */
+	struct heap_elem edf_elem;          /* Element in edf_queue. */
+
+	/* tid로 스레드를 찾기 위한 해시 elem */
+	struct hash_elem tid_elem;
+
+	/* 자원 사용량, 기다린 자식들의 사용량은 child_usage에 합산 */
+	struct rusage usage;
+	struct rusage child_usage;
+
 	/* P2. 자식이 부모에게 전달할 종료 상태 */
 	int exit_status;
 
@@ -142,9 +191,19 @@ struct thread {
 	/* P2. 자식 목록과 자식 리스트에 넣어지기 위한 elem */
 	struct list child_list;
 	struct list_elem child_elem;
+	struct thread *parent;              /* 자식 리스트에 넣은 부모 */
 
-	/* P2. FD 집합 */
+	/* clone()으로 만든 스레드는 leader의 주소 공간, SPT, FD 집합을 같이 씀 */
+	struct thread *leader;              /* Owner of pml4, spt and fds. */
+	int thread_cnt;                     /* Leader: live threads, itself included. */
+	struct list threads;                /* Leader: threads made by clone(). */
+	struct list_elem thread_elem;       /* Element in leader's threads. */
+	struct semaphore threads_done;      /* Leader: up'd by the last thread. */
+	bool dying;                         /* Process is exiting: do not return to user. */
+
+	/* P2. FD 집합. 같은 프로세스의 스레드끼리 공유하므로 fd_lock으로 보호 */
 	struct file *fds[FD_MAX];
+	struct lock fd_lock;
 
 	/* kerenel level process인지 확인용 */
 	bool is_kernel;
@@ -171,7 +230,8 @@ struct thread {
 #endif
 
 	/* Owned by thread.c. */
-	struct intr_frame tf;               /* Information for switching */
+	uint64_t switch_rsp;                /* Saved kernel stack pointer, or 0. */
+	struct intr_frame tf;               /* Information for first launch */
 	unsigned magic;                     /* Detects stack overflow. */
 };
 
@@ -180,10 +240,14 @@ struct thread {
    Controlled by kernel command-line option "-o mlfqs". */
 extern bool thread_mlfqs;
 
+/* If true, use the completely fair (virtual runtime) scheduler.
+   Controlled by kernel command-line option "-cfs". */
+extern bool thread_cfs;
+
 void thread_init (void);
 void thread_start (void);
 
-void thread_tick (void);
+void thread_tick (const struct intr_frame *);
 void thread_print_stats (void);
 
 typedef void thread_func (void *aux);
@@ -212,11 +276,11 @@ void do_iret (struct intr_frame *tf);
 /* [P1-1] 헤더 파일 선언 */
 void thread_sleep(int64_t ticks);
 bool thread_wakeup(int64_t ticks);
-bool compare_wakeup_tick(const struct list_elem *a, const struct list_elem *b, void *aux);
+int64_t thread_next_wakeup(void);
 
 /* [P1-2] 헤더 파일 선언 */
-bool compare_priority(const struct list_elem *a, const struct list_elem *b, void *aux);
 void thread_preempt(void);
+void thread_change_priority(struct thread *t, int priority);
 
 /* [P1-3] 헤더 파일 선언 */
 void calculate_priority(struct thread *t);
@@ -225,7 +289,11 @@ void recalculate_priority(void);
 void recalculate_recent_cpu(void);
 void recalculate_load_avg(void);
 
-struct thread* thread_get_highest_priority();
+struct thread* thread_get_highest_priority(void);
+
+void thread_io_begin (void);
+void thread_io_end (void);
+bool thread_set_deadline(int64_t runtime, int64_t deadline, int64_t period);
 struct thread* thread_get_by_tid(tid_t tid);
 
 #endif /* threads/thread.h */
@@ -0,0 +1,52 @@
+#ifndef THREADS_WORKQUEUE_H
+#define THREADS_WORKQUEUE_H
+
+#include <heap.h>
+#include <list.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Asynchronous kernel work.  See threads/workqueue.c. */
+
+struct workqueue;
+
+/* Function run by a worker thread, given a work's AUX. */
+typedef void work_func (void *aux);
+
+/* A unit of work.  Embedded in the structure it works on, and set
+   up with work_init() before it is first queued.  Only the
+   workqueue code touches the members. */
+struct work {
+	struct list_elem elem;      /* In a workqueue's list of works. */
+	struct heap_elem delay_elem; /* In the heap of delayed works. */
+	work_func *func;            /* Function to run. */
+	void *aux;                  /* Argument for func. */
+	struct workqueue *wq;       /* Queue it was last queued on. */
+	int64_t due;                /* Delayed: tick to queue at, else 0. */
+	bool pending;               /* Queued or delayed, not yet run? */
+};
+
+/* Queue with one worker thread per CPU or so, for work that may
+   sleep but should not hold up the thread that requested it. */
+extern struct workqueue *system_wq;
+
+void workqueue_init (void);
+struct workqueue *workqueue_create (const char *name, int worker_cnt,
+		int priority);
+void workqueue_destroy (struct workqueue *);
+
+void work_init (struct work *, work_func *, void *aux);
+bool queue_work (struct workqueue *, struct work *);
+bool queue_delayed_work (struct workqueue *, struct work *, int64_t ticks);
+bool cancel_work (struct work *);
+bool cancel_work_sync (struct work *);
+void flush_work (struct work *);
+void flush_workqueue (struct workqueue *);
+
+bool schedule_work (struct work *);
+bool schedule_delayed_work (struct work *, int64_t ticks);
+
+void workqueue_timer (int64_t now);
+int64_t workqueue_next_due (void);
+
+#endif /* threads/workqueue.h */
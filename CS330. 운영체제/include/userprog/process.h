@@ -3,16 +3,20 @@
 
 #include "threads/thread.h"
 
-static struct lock file_lock;
-
 tid_t process_create_initd (const char *file_name);
 tid_t process_fork (const char *name);
 int process_exec (void *f_name);
 int process_wait (tid_t);
+tid_t process_clone (void *start, uint64_t arg0, uint64_t arg1, void *stack);
+int process_join (tid_t);
 void process_exit (void);
+void process_exit_if_dying (void);
 void process_activate (struct thread *next);
 
-void process_lock_file();
-void process_release_file();
+void process_init_file_lock(void);
+void process_lock_file(void);
+void process_lock_file_read(void);
+void process_release_file(void);
+bool process_file_held(void);
 
 #endif /* userprog/process.h */
@@ -9,7 +9,10 @@ void syscall_init (void);
 #include <stdbool.h>
 /* P3. size_t, off_t 헤더파일 추가 */
 #include <stddef.h>
+#include <stdint.h>
 #include "filesys/off_t.h"
+/* getrusage의 struct rusage */
+#include <rusage.h>
 
 /* P2. 커널에서 pid_t 타입 선언 */
 typedef int pid_t;
@@ -39,6 +42,10 @@ bool readdir(int fd, char *name);
 bool isdir(int fd);
 int inumber(int fd);
 int symlink(const char *target, const char *linkpath);
+int sched_deadline(unsigned runtime, unsigned deadline, unsigned period);
+int getrusage(int who, struct rusage *usage);
+pid_t clone(void *start, uint64_t arg0, uint64_t arg1, void *stack);
+int join(pid_t tid);
 
 void check_buffer(const void *buffer, unsigned size);
 void is_valid_ptr_writable(const void *ptr);
@@ -3,6 +3,8 @@
 #include <stdbool.h>
 #include "threads/palloc.h"
 #include <hash.h>
+#include "threads/synch.h"
+#include "threads/slab.h"
 
 enum vm_type {
 	/* page not initialized */
@@ -86,6 +88,10 @@ struct segment_aux {
 	bool writable;              // [P3-2] 페이지의 쓰기 가능 여부
 };
 
+/* Cache of struct segment_aux, which vm.c, vm/file.c, vm/uninit.c
+   and userprog/process.c allocate and free. */
+extern struct kmem_cache *segment_aux_cache;
+
 /* The function table for page operations.
  * This is one way of implementing "interface" in C.
  * Put the table of "method" into the struct's member, and
@@ -108,6 +114,7 @@ struct page_operations {
 
 struct supplemental_page_table {
 	struct hash hash; // [P3-1] 해시 사용
+	struct lock lock;           /* Shared by threads made by clone(). */
 };
 
 #include "threads/thread.h"
@@ -23,10 +23,26 @@ typedef unsigned long elem_type;
 
 /* From the outside, a bitmap is an array of bits.  From the
    inside, it's an array of elem_type (defined above) that
-   simulates an array of bits. */
+   simulates an array of bits.
+
+   Two summary bitmaps, with one bit per element of BITS, let
+   searches skip whole elements at a time: bit K of ANY is set if
+   element K has any bit set, and bit K of FULL is set if every
+   bit of element K is set.  A search for a true bit looks only
+   at elements that ANY marks, and one for a false bit only at
+   elements that FULL does not, so it examines one summary bit
+   per element instead of every bit.  The summaries are kept in
+   the same storage as BITS, right after it.
+
+   Each element and its summary bits are updated separately, so
+   concurrent writers of the same bitmap must be serialized by
+   the caller, as they already must be for bitmap_scan_and_flip()
+   to be meaningful. */
 struct bitmap {
 	size_t bit_cnt;     /* Number of bits. */
 	elem_type *bits;    /* Elements that represent bits. */
+	elem_type *any;     /* Elements of BITS with a bit set. */
+	elem_type *full;    /* Elements of BITS with every bit set. */
 };
 
 /* Returns the index of the element that contains the bit
@@ -55,6 +71,13 @@ byte_cnt (size_t bit_cnt) {
 	return sizeof (elem_type) * elem_cnt (bit_cnt);
 }
 
+/* Returns the number of bytes required for BIT_CNT bits and
+   their two summaries. */
+static inline size_t
+storage_cnt (size_t bit_cnt) {
+	return byte_cnt (bit_cnt) + 2 * byte_cnt (elem_cnt (bit_cnt));
+}
+
 /* Returns a bit mask in which the bits actually used in the last
    element of B's bits are set to 1 and the rest are set to 0. */
 static inline elem_type
@@ -62,6 +85,83 @@ last_mask (const struct bitmap *b) {
 	int last_bits = b->bit_cnt % ELEM_BITS;
 	return last_bits ? ((elem_type) 1 << last_bits) - 1 : (elem_type) -1;
 }
+
+/* Returns a mask of the bits of element ELEM_IDX of B that are
+   part of the bitmap. */
+static inline elem_type
+elem_mask (const struct bitmap *b, size_t elem_idx) {
+	return elem_idx == elem_cnt (b->bit_cnt) - 1 ? last_mask (b) : (elem_type) -1;
+}
+
+/* Returns the index of the lowest bit set in nonzero X. */
+static inline size_t
+lowest_bit (elem_type x) {
+	return __builtin_ctzl (x);
+}
+
+/* Points B's summaries into the storage after B->bits. */
+static void
+init_summaries (struct bitmap *b) {
+	b->any = b->bits + elem_cnt (b->bit_cnt);
+	b->full = b->any + elem_cnt (elem_cnt (b->bit_cnt));
+}
+
+/* Brings the summary bits of element ELEM_IDX of B up to date. */
+static void
+update_summary (struct bitmap *b, size_t elem_idx) {
+	elem_type value = b->bits[elem_idx] & elem_mask (b, elem_idx);
+	size_t idx = elem_idx / ELEM_BITS;
+	elem_type mask = bit_mask (elem_idx);
+
+	if (value != 0)
+		asm ("lock orq %1, %0" : "=m" (b->any[idx]) : "r" (mask) : "cc");
+	else
+		asm ("lock andq %1, %0" : "=m" (b->any[idx]) : "r" (~mask) : "cc");
+	if (value == elem_mask (b, elem_idx))
+		asm ("lock orq %1, %0" : "=m" (b->full[idx]) : "r" (mask) : "cc");
+	else
+		asm ("lock andq %1, %0" : "=m" (b->full[idx]) : "r" (~mask) : "cc");
+}
+
+/* Returns the bits of element ELEM_IDX of B that are set to
+   VALUE, counting only bits that are part of the bitmap. */
+static inline elem_type
+elem_matches (const struct bitmap *b, size_t elem_idx, bool value) {
+	elem_type bits = b->bits[elem_idx];
+	return (value ? bits : ~bits) & elem_mask (b, elem_idx);
+}
+
+/* Returns the index of the first bit at or after START in B that
+   is set to VALUE, or B's size if there is none. */
+static size_t
+find_next (const struct bitmap *b, size_t start, bool value) {
+	size_t elem_total = elem_cnt (b->bit_cnt);
+	size_t ei, si;
+	elem_type m;
+
+	if (start >= b->bit_cnt)
+		return b->bit_cnt;
+
+	/* START가 들어 있는 원소부터 확인 */
+	ei = elem_idx (start);
+	m = elem_matches (b, ei, value) & ((elem_type) -1 << (start % ELEM_BITS));
+	if (m != 0)
+		return ei * ELEM_BITS + lowest_bit (m);
+
+	/* 이후는 요약 비트로 VALUE가 있는 원소만 찾아감 */
+	for (ei++; ei < elem_total; ei = (si + 1) * ELEM_BITS) {
+		si = ei / ELEM_BITS;
+		m = value ? b->any[si] : ~b->full[si];
+		m &= (elem_type) -1 << (ei % ELEM_BITS);
+		if (m != 0) {
+			ei = si * ELEM_BITS + lowest_bit (m);
+			if (ei >= elem_total)
+				break;
+			return ei * ELEM_BITS + lowest_bit (elem_matches (b, ei, value));
+		}
+	}
+	return b->bit_cnt;
+}
 
 /* Creation and destruction. */
 
@@ -74,8 +174,9 @@ bitmap_create (size_t bit_cnt) {
 	struct bitmap *b = malloc (sizeof *b);
 	if (b != NULL) {
 		b->bit_cnt = bit_cnt;
-		b->bits = malloc (byte_cnt (bit_cnt));
+		b->bits = malloc (storage_cnt (bit_cnt));
 		if (b->bits != NULL || bit_cnt == 0) {
+			init_summaries (b);
 			bitmap_set_all (b, false);
 			return b;
 		}
@@ -95,6 +196,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED) {
 
 	b->bit_cnt = bit_cnt;
 	b->bits = (elem_type *) (b + 1);
+	init_summaries (b);
 	bitmap_set_all (b, false);
 	return b;
 }
@@ -103,7 +205,7 @@ bitmap_create_in_buf (size_t bit_cnt, void *block, size_t block_size UNUSED) {
    with BIT_CNT bits (for use with bitmap_create_in_buf()). */
 size_t
 bitmap_buf_size (size_t bit_cnt) {
-	return sizeof (struct bitmap) + byte_cnt (bit_cnt);
+	return sizeof (struct bitmap) + storage_cnt (bit_cnt);
 }
 
 /* Destroys bitmap B, freeing its storage.
@@ -148,6 +250,7 @@ bitmap_mark (struct bitmap *b, size_t bit_idx) {
 	   is guaranteed to be atomic on a uniprocessor machine.  See
 	   the description of the OR instruction in [IA32-v2b]. */
 	asm ("lock orq %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+	update_summary (b, idx);
 }
 
 /* Atomically sets the bit numbered BIT_IDX in B to false. */
@@ -160,6 +263,7 @@ bitmap_reset (struct bitmap *b, size_t bit_idx) {
 	   is guaranteed to be atomic on a uniprocessor machine.  See
 	   the description of the AND instruction in [IA32-v2a]. */
 	asm ("lock andq %1, %0" : "=m" (b->bits[idx]) : "r" (~mask) : "cc");
+	update_summary (b, idx);
 }
 
 /* Atomically toggles the bit numbered IDX in B;
@@ -174,6 +278,7 @@ bitmap_flip (struct bitmap *b, size_t bit_idx) {
 	   is guaranteed to be atomic on a uniprocessor machine.  See
 	   the description of the XOR instruction in [IA32-v2b]. */
 	asm ("lock xorq %1, %0" : "=m" (b->bits[idx]) : "r" (mask) : "cc");
+	update_summary (b, idx);
 }
 
 /* Returns the value of the bit numbered IDX in B. */
@@ -194,17 +299,30 @@ bitmap_set_all (struct bitmap *b, bool value) {
 	bitmap_set_multiple (b, 0, bitmap_size (b), value);
 }
 
-/* Sets the CNT bits starting at START in B to VALUE. */
+/* Sets the CNT bits starting at START in B to VALUE.
+   Sets a whole element of bits at a time. */
 void
 bitmap_set_multiple (struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i;
+	size_t end = start + cnt;
 
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		bitmap_set (b, start + i, value);
+	while (start < end) {
+		size_t idx = elem_idx (start);
+		size_t ofs = start % ELEM_BITS;
+		size_t n = ELEM_BITS - ofs < end - start ? ELEM_BITS - ofs : end - start;
+		elem_type mask = (n == ELEM_BITS ? (elem_type) -1
+				: (((elem_type) 1 << n) - 1)) << ofs;
+
+		if (value)
+			b->bits[idx] |= mask;
+		else
+			b->bits[idx] &= ~mask;
+		update_summary (b, idx);
+		start += n;
+	}
 }
 
 /* Returns the number of bits in B between START and START + CNT,
@@ -217,10 +335,21 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) {
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
+	/* 원소 단위로 세고 범위를 넘는 비트는 빼 줌 */
 	value_cnt = 0;
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test (b, start + i) == value)
+	for (i = start; i < start + cnt; ) {
+		size_t idx = elem_idx (i);
+		elem_type m = elem_matches (b, idx, value) >> (i % ELEM_BITS);
+		size_t n = ELEM_BITS - i % ELEM_BITS;
+
+		if (n > start + cnt - i) {
+			n = start + cnt - i;
+			m &= ((elem_type) 1 << n) - 1;
+		}
+		for (; m != 0; m &= m - 1)
 			value_cnt++;
+		i += n;
+	}
 	return value_cnt;
 }
 
@@ -228,16 +357,11 @@ bitmap_count (const struct bitmap *b, size_t start, size_t cnt, bool value) {
    exclusive, are set to VALUE, and false otherwise. */
 bool
 bitmap_contains (const struct bitmap *b, size_t start, size_t cnt, bool value) {
-	size_t i;
-
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 	ASSERT (start + cnt <= b->bit_cnt);
 
-	for (i = 0; i < cnt; i++)
-		if (bitmap_test (b, start + i) == value)
-			return true;
-	return false;
+	return cnt > 0 && find_next (b, start, value) < start + cnt;
 }
 
 /* Returns true if any bits in B between START and START + CNT,
@@ -266,18 +390,27 @@ bitmap_all (const struct bitmap *b, size_t start, size_t cnt) {
 /* Finds and returns the starting index of the first group of CNT
    consecutive bits in B at or after START that are all set to
    VALUE.
-   If there is no such group, returns BITMAP_ERROR. */
+   If there is no such group, returns BITMAP_ERROR.
+   Jumps from each run of VALUE bits to the end of the run, so
+   it visits each element, or each summary bit for elements
+   without a match, about once. */
 size_t
 bitmap_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) {
 	ASSERT (b != NULL);
 	ASSERT (start <= b->bit_cnt);
 
-	if (cnt <= b->bit_cnt) {
-		size_t last = b->bit_cnt - cnt;
-		size_t i;
-		for (i = start; i <= last; i++)
-			if (!bitmap_contains (b, i, cnt, !value))
-				return i;
+	if (cnt == 0)
+		return start;
+	while (cnt <= b->bit_cnt - start) {
+		size_t end;
+
+		start = find_next (b, start, value);
+		if (cnt > b->bit_cnt - start)
+			break;
+		end = find_next (b, start, !value);
+		if (end - start >= cnt)
+			return start;
+		start = end;
 	}
 	return BITMAP_ERROR;
 }
@@ -315,6 +448,8 @@ bitmap_read (struct bitmap *b, struct file *file) {
 		off_t size = byte_cnt (b->bit_cnt);
 		success = file_read_at (file, b->bits, size, 0) == size;
 		b->bits[elem_cnt (b->bit_cnt) - 1] &= last_mask (b);
+		for (size_t i = 0; i < elem_cnt (b->bit_cnt); i++)
+			update_summary (b, i);
 	}
 	return success;
 }
@@ -0,0 +1,178 @@
+/* Max-heap (priority queue).
+
+   See heap.h for basic information. */
+
+#include "heap.h"
+#include "../debug.h"
+
+static struct heap_elem *meld (struct heap *,
+		struct heap_elem *, struct heap_elem *);
+static struct heap_elem *merge_pairs (struct heap *, struct heap_elem *);
+static void detach (struct heap *, struct heap_elem *);
+
+/* Initializes HEAP as an empty heap ordered by LESS, given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *heap, heap_less_func *less, void *aux) {
+	ASSERT (heap != NULL);
+	ASSERT (less != NULL);
+
+	heap->root = NULL;
+	heap->elem_cnt = 0;
+	heap->less = less;
+	heap->aux = aux;
+}
+
+/* Inserts ELEM into HEAP. */
+void
+heap_insert (struct heap *heap, struct heap_elem *elem) {
+	ASSERT (heap != NULL);
+	ASSERT (elem != NULL);
+
+	elem->child = elem->next = elem->prev = NULL;
+	heap->root = meld (heap, heap->root, elem);
+	heap->elem_cnt++;
+}
+
+/* Returns the maximum element in HEAP, or a null pointer if HEAP
+   is empty.  If several elements are equal, which one is returned
+   is unspecified; break ties in LESS to make it deterministic. */
+struct heap_elem *
+heap_max (const struct heap *heap) {
+	ASSERT (heap != NULL);
+
+	return heap->root;
+}
+
+/* Removes and returns the maximum element in HEAP, which must not
+   be empty. */
+struct heap_elem *
+heap_pop_max (struct heap *heap) {
+	struct heap_elem *max;
+
+	ASSERT (heap != NULL);
+	ASSERT (heap->root != NULL);
+
+	max = heap->root;
+	heap->root = merge_pairs (heap, max->child);
+	if (heap->root != NULL)
+		heap->root->prev = NULL;
+	heap->elem_cnt--;
+
+	max->child = max->next = max->prev = NULL;
+	return max;
+}
+
+/* Removes ELEM, which must be in HEAP, from HEAP. */
+void
+heap_remove (struct heap *heap, struct heap_elem *elem) {
+	ASSERT (heap != NULL);
+	ASSERT (elem != NULL);
+
+	if (elem == heap->root) {
+		heap_pop_max (heap);
+		return;
+	}
+
+	detach (heap, elem);
+	heap->root = meld (heap, heap->root, merge_pairs (heap, elem->child));
+	heap->root->prev = NULL;
+	heap->elem_cnt--;
+
+	elem->child = elem->next = elem->prev = NULL;
+}
+
+/* Restores the heap property after the value of ELEM, which must
+   be in HEAP, has changed. */
+void
+heap_update (struct heap *heap, struct heap_elem *elem) {
+	heap_remove (heap, elem);
+	heap_insert (heap, elem);
+}
+
+/* Returns the number of elements in HEAP. */
+size_t
+heap_size (const struct heap *heap) {
+	return heap->elem_cnt;
+}
+
+/* Returns true if HEAP contains no elements, false otherwise. */
+bool
+heap_empty (const struct heap *heap) {
+	return heap->root == NULL;
+}
+
+/* Combines the trees rooted at A and B, either of which may be
+   null, and returns the new root.  The smaller root becomes the
+   leftmost child of the larger one. */
+static struct heap_elem *
+meld (struct heap *heap, struct heap_elem *a, struct heap_elem *b) {
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+	if (heap->less (a, b, heap->aux)) {
+		struct heap_elem *t = a;
+		a = b;
+		b = t;
+	}
+
+	/* B becomes A's leftmost child. */
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	b->prev = a;
+	a->child = b;
+	a->next = NULL;
+	return a;
+}
+
+/* Melds the sibling list starting at FIRST into a single tree and
+   returns its root, using the standard two passes: pair up
+   siblings from left to right, then meld the pairs from right to
+   left.  Runs iteratively so deep heaps cannot overflow the
+   kernel stack. */
+static struct heap_elem *
+merge_pairs (struct heap *heap, struct heap_elem *first) {
+	struct heap_elem *pairs = NULL;     /* Stack of melded pairs. */
+	struct heap_elem *root = NULL;
+
+	while (first != NULL) {
+		struct heap_elem *a = first;
+		struct heap_elem *b = a->next;
+		struct heap_elem *pair;
+
+		first = b != NULL ? b->next : NULL;
+		a->next = a->prev = NULL;
+		if (b != NULL)
+			b->next = b->prev = NULL;
+
+		pair = meld (heap, a, b);
+		pair->next = pairs;
+		pairs = pair;
+	}
+
+	while (pairs != NULL) {
+		struct heap_elem *pair = pairs;
+
+		pairs = pair->next;
+		pair->next = NULL;
+		root = meld (heap, root, pair);
+	}
+	return root;
+}
+
+/* Cuts the subtree rooted at ELEM, which must not be the root,
+   out of HEAP's tree. */
+static void
+detach (struct heap *heap UNUSED, struct heap_elem *elem) {
+	ASSERT (elem->prev != NULL);
+
+	if (elem->prev->child == elem)
+		elem->prev->child = elem->next;
+	else
+		elem->prev->next = elem->next;
+	if (elem->next != NULL)
+		elem->next->prev = elem->prev;
+	elem->next = elem->prev = NULL;
+}
@@ -0,0 +1,89 @@
+#include <sync.h>
+#include <limits.h>
+#include <syscall.h>
+
+/* The mutex is the three-state futex mutex from Ulrich Drepper,
+   "Futexes Are Tricky".  A locker that finds the mutex taken
+   sets the state to 2 before sleeping, so that the unlocker
+   knows it has to call futex_wake(); a locker that finds it free
+   takes it with a single compare-and-swap. */
+
+/* Initializes M as unlocked. */
+void
+mutex_init (struct mutex *m) {
+	m->state = 0;
+}
+
+/* Acquires M, sleeping until it is available if necessary. */
+void
+mutex_lock (struct mutex *m) {
+	int c = 0;
+
+	if (__atomic_compare_exchange_n (&m->state, &c, 1, false,
+				__ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+		return;
+
+	/* 경쟁 중: 대기자가 있다고 표시한 뒤 잠듦 */
+	if (c != 2)
+		c = __atomic_exchange_n (&m->state, 2, __ATOMIC_ACQUIRE);
+	while (c != 0) {
+		futex_wait (&m->state, 2);
+		c = __atomic_exchange_n (&m->state, 2, __ATOMIC_ACQUIRE);
+	}
+}
+
+/* Acquires M if it is free and returns true, or returns false
+   without sleeping. */
+bool
+mutex_trylock (struct mutex *m) {
+	int c = 0;
+
+	return __atomic_compare_exchange_n (&m->state, &c, 1, false,
+			__ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+/* Releases M, which the caller must hold. */
+void
+mutex_unlock (struct mutex *m) {
+	/* 1이었으면 기다리는 스레드가 없음 */
+	if (__atomic_fetch_sub (&m->state, 1, __ATOMIC_RELEASE) != 1) {
+		__atomic_store_n (&m->state, 0, __ATOMIC_RELEASE);
+		futex_wake (&m->state, 1);
+	}
+}
+
+/* Initializes CV. */
+void
+condvar_init (struct condvar *cv) {
+	cv->seq = 0;
+}
+
+/* Atomically releases M and waits for CV to be signaled, then
+   reacquires M.  M must be held.  As with any condition variable,
+   the caller should recheck its condition after waking up. */
+void
+condvar_wait (struct condvar *cv, struct mutex *m) {
+	int seq = __atomic_load_n (&cv->seq, __ATOMIC_RELAXED);
+
+	mutex_unlock (m);
+	/* unlock 뒤에 signal이 오면 seq가 바뀌어 바로 돌아옴 */
+	futex_wait (&cv->seq, seq);
+
+	/* 다른 대기자가 있을 수 있으므로 상태 2로 다시 잡음 */
+	while (__atomic_exchange_n (&m->state, 2, __ATOMIC_ACQUIRE) != 0)
+		futex_wait (&m->state, 2);
+}
+
+/* Wakes one thread waiting on CV, if any. */
+void
+condvar_signal (struct condvar *cv) {
+	__atomic_fetch_add (&cv->seq, 1, __ATOMIC_RELEASE);
+	futex_wake (&cv->seq, 1);
+}
+
+/* Wakes every thread waiting on CV. */
+void
+condvar_broadcast (struct condvar *cv) {
+	__atomic_fetch_add (&cv->seq, 1, __ATOMIC_RELEASE);
+	futex_wake (&cv->seq, INT_MAX);
+}
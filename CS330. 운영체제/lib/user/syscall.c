@@ -54,7 +54,7 @@ static __inline int64_t syscall (uint64_t num_, uint64_t a1_, uint64_t a2_,
 			((uint64_t) ARG2), 0, 0, 0))
 
 #define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3) ( \
-		syscall(((uint64_t *) NUMBER), \
+		syscall(((uint64_t) NUMBER), \
 			((uint64_t) ARG0), \
 			((uint64_t) ARG1), \
 			((uint64_t) ARG2), \
@@ -185,6 +185,43 @@ symlink (const char* target, const char* linkpath) {
 	return syscall2 (SYS_SYMLINK, target, linkpath);
 }
 
+int
+sched_deadline (unsigned runtime, unsigned deadline, unsigned period) {
+	return syscall3 (SYS_SCHED_DEADLINE, runtime, deadline, period);
+}
+
+int
+getrusage (int who, struct rusage *usage) {
+	return syscall2 (SYS_GETRUSAGE, who, usage);
+}
+
+int
+futex_wait (int *uaddr, int val) {
+	return syscall2 (SYS_FUTEX_WAIT, uaddr, val);
+}
+
+int
+futex_wake (int *uaddr, int cnt) {
+	return syscall2 (SYS_FUTEX_WAKE, uaddr, cnt);
+}
+
+/* Where a thread made by clone() starts: the kernel does not let
+   it return, so its function's result is passed to exit(). */
+static void NO_RETURN
+clone_start (int (*func) (void *), void *aux) {
+	exit (func (aux));
+}
+
+pid_t
+clone (int (*func) (void *), void *aux, void *stack) {
+	return (pid_t) syscall4 (SYS_CLONE, clone_start, func, aux, stack);
+}
+
+int
+join (pid_t tid) {
+	return syscall1 (SYS_JOIN, tid);
+}
+
 int
 mount (const char *path, int chan_no, int dev_no) {
 	return syscall3 (SYS_MOUNT, path, chan_no, dev_no);
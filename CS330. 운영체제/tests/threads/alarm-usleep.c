@@ -0,0 +1,61 @@
+/* Tests timer_usleep() for sleeps shorter than a timer tick.
+   Each sleep must last at least as long as asked, and, since
+   such sleeps block on a high-resolution timer instead of
+   busy-waiting, a lower-priority thread must get to run while a
+   higher-priority one sleeps. */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "devices/hrtimer.h"
+#include "devices/timer.h"
+
+/* Number of sleeps done by the sleeper thread. */
+#define SLEEP_CNT 10
+
+static thread_func sleeper;
+static volatile bool done;
+
+void
+test_alarm_usleep (void) 
+{
+  static const int64_t lengths[] = {1, 10, 100, 1000, 5000};
+  uint64_t spins = 0;
+  size_t i;
+
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  if (!hrtimer_available ())
+    fail ("no interrupt for high-resolution timers");
+
+  for (i = 0; i < sizeof lengths / sizeof *lengths; i++) 
+    {
+      uint64_t start = hrtimer_now ();
+
+      timer_usleep (lengths[i]);
+      if (hrtimer_now () - start < hrtimer_ns_to_cycles (lengths[i] * 1000))
+        fail ("timer_usleep (%"PRId64") returned early", lengths[i]);
+    }
+  msg ("Every sleep lasted long enough.");
+
+  done = false;
+  thread_create ("sleeper", PRI_DEFAULT + 1, sleeper, NULL);
+  while (!done)
+    spins++;
+  if (spins == 0)
+    fail ("main thread did not run while the sleeper slept");
+  msg ("Main thread ran while the sleeper slept.");
+}
+
+static void
+sleeper (void *aux UNUSED) 
+{
+  int i;
+
+  for (i = 0; i < SLEEP_CNT; i++)
+    timer_usleep (5000);
+  done = true;
+}
@@ -0,0 +1,11 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(alarm-usleep) begin
+(alarm-usleep) Every sleep lasted long enough.
+(alarm-usleep) Main thread ran while the sleeper slept.
+(alarm-usleep) end
+EOF
+pass;
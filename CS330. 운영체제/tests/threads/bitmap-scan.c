@@ -0,0 +1,133 @@
+/* Tests bitmap_scan(), bitmap_count() and bitmap_contains(),
+   which skip whole elements using summaries, against searches
+   that look at one bit at a time.  Bitmaps of several sizes,
+   around and across element boundaries, are filled at several
+   densities with bitmap_set() and bitmap_set_multiple() and
+   then searched from many starting points.  bitmap_scan_and_flip()
+   is used until no run is left. */
+
+#include <bitmap.h>
+#include <random.h>
+#include <stdio.h>
+#include "tests/threads/tests.h"
+
+/* Returns the number of bits in B[START, START + CNT) equal to
+   VALUE, testing them one by one. */
+static size_t
+slow_count (const struct bitmap *b, size_t start, size_t cnt, bool value) 
+{
+  size_t i, n = 0;
+
+  for (i = start; i < start + cnt; i++)
+    if (bitmap_test (b, i) == value)
+      n++;
+  return n;
+}
+
+/* Returns the start of the first run of CNT bits equal to VALUE
+   at or after START, testing bits one by one. */
+static size_t
+slow_scan (const struct bitmap *b, size_t start, size_t cnt, bool value) 
+{
+  size_t i, run = 0;
+
+  for (i = start; i < bitmap_size (b); i++)
+    {
+      run = bitmap_test (b, i) == value ? run + 1 : 0;
+      if (run == cnt)
+        return i + 1 - cnt;
+    }
+  return BITMAP_ERROR;
+}
+
+/* Fills B so that about one bit in DENSITY is set, or none if
+   DENSITY is 0.  Every so often a whole run is set or reset. */
+static void
+fill (struct bitmap *b, unsigned density) 
+{
+  size_t size = bitmap_size (b);
+  size_t i;
+
+  bitmap_set_all (b, false);
+  if (density == 0)
+    return;
+  for (i = 0; i < size; i++)
+    bitmap_set (b, i, random_ulong () % density == 0);
+  for (i = 0; i < size / 32; i++) 
+    {
+      size_t start = random_ulong () % size;
+      size_t cnt = random_ulong () % (size - start + 1);
+
+      bitmap_set_multiple (b, start, cnt, random_ulong () % 2);
+    }
+}
+
+/* Checks searches on B from every starting point, or from every
+   STEP'th one in big bitmaps, to keep the test short. */
+static void
+check (const struct bitmap *b) 
+{
+  static const size_t cnts[] = {1, 2, 3, 7, 31, 64, 65, 130};
+  size_t size = bitmap_size (b);
+  size_t step = size > 200 ? 13 : 1;
+  size_t start, i;
+  int value;
+
+  for (start = 0; start <= size; start += step)
+    for (value = 0; value <= 1; value++) 
+      {
+        for (i = 0; i < sizeof cnts / sizeof *cnts; i++)
+          if (bitmap_scan (b, start, cnts[i], value)
+              != slow_scan (b, start, cnts[i], value))
+            fail ("bitmap_scan (%zu, %zu, %d) on %zu bits is wrong",
+                  start, cnts[i], value, size);
+        if (bitmap_count (b, start, size - start, value)
+            != slow_count (b, start, size - start, value))
+          fail ("bitmap_count (%zu, %d) on %zu bits is wrong",
+                start, value, size);
+        if (bitmap_contains (b, 0, start, value)
+            != (slow_count (b, 0, start, value) > 0))
+          fail ("bitmap_contains (%zu, %d) on %zu bits is wrong",
+                start, value, size);
+      }
+}
+
+void
+test_bitmap_scan (void) 
+{
+  static const size_t sizes[] = {1, 63, 64, 65, 127, 200, 1000};
+  static const unsigned densities[] = {0, 1, 2, 16, 200};
+  size_t i, j;
+
+  random_init (0);
+  for (i = 0; i < sizeof sizes / sizeof *sizes; i++) 
+    {
+      struct bitmap *b = bitmap_create (sizes[i]);
+
+      if (b == NULL)
+        fail ("bitmap_create (%zu) failed", sizes[i]);
+      for (j = 0; j < sizeof densities / sizeof *densities; j++) 
+        {
+          size_t idx, expected;
+
+          fill (b, densities[j]);
+          check (b);
+
+          /* Take runs of 3 free bits until none is left. */
+          for (;;) 
+            {
+              expected = slow_scan (b, 0, 3, false);
+              idx = bitmap_scan_and_flip (b, 0, 3, false);
+              if (idx != expected)
+                fail ("bitmap_scan_and_flip on %zu bits is wrong", sizes[i]);
+              if (idx == BITMAP_ERROR)
+                break;
+              if (!bitmap_all (b, idx, 3))
+                fail ("bitmap_scan_and_flip did not flip its bits");
+            }
+          check (b);
+        }
+      bitmap_destroy (b);
+    }
+  msg ("Fast and slow searches agree.");
+}
@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(bitmap-scan) begin
+(bitmap-scan) Fast and slow searches agree.
+(bitmap-scan) end
+EOF
+pass;
@@ -0,0 +1,93 @@
+/* Checks that the -cfs scheduler shares the CPU in proportion to
+   weight.  Two threads spin for 10 seconds, one at nice 0 and the
+   other at nice 5, whose weights are 1024 and 335.  The first
+   should get 1024 / 1359, about 75%, of the ticks the two of them
+   receive, and the second about 25%.  A share more than
+   TOLERANCE percentage points off fails the test. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+#define THREAD_CNT 2
+#define TOLERANCE 5
+
+struct thread_info
+  {
+    int64_t start_time;
+    int tick_count;
+    int nice;
+    int weight;
+  };
+
+static thread_func load_thread;
+
+void
+test_cfs_nice (void)
+{
+  struct thread_info info[THREAD_CNT] = {
+    {0, 0, 0, 1024},
+    {0, 0, 5, 335},
+  };
+  int64_t start_time;
+  int total_ticks = 0;
+  int total_weight = 0;
+  int i;
+
+  ASSERT (thread_cfs);
+
+  start_time = timer_ticks ();
+  msg ("Starting %d threads...", THREAD_CNT);
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      char name[16];
+
+      info[i].start_time = start_time;
+      snprintf (name, sizeof name, "load %d", i);
+      thread_create (name, PRI_DEFAULT, load_thread, &info[i]);
+    }
+
+  msg ("Sleeping 12 seconds to let threads run, please wait...");
+  timer_sleep (12 * TIMER_FREQ);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      total_ticks += info[i].tick_count;
+      total_weight += info[i].weight;
+    }
+  if (total_ticks < 5 * TIMER_FREQ)
+    fail ("threads received only %d ticks in total", total_ticks);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    {
+      int share = info[i].tick_count * 100 / total_ticks;
+      int expected = info[i].weight * 100 / total_weight;
+
+      if (share < expected - TOLERANCE || share > expected + TOLERANCE)
+        fail ("thread at nice %d received %d%% of the ticks, "
+              "expected %d%%", info[i].nice, share, expected);
+      msg ("Thread at nice %d received about %d%% of the ticks.",
+           info[i].nice, expected);
+    }
+}
+
+static void
+load_thread (void *ti_)
+{
+  struct thread_info *ti = ti_;
+  int64_t sleep_time = 1 * TIMER_FREQ;
+  int64_t spin_time = sleep_time + 10 * TIMER_FREQ;
+  int64_t last_time = 0;
+
+  thread_set_nice (ti->nice);
+  timer_sleep (sleep_time - timer_elapsed (ti->start_time));
+  while (timer_elapsed (ti->start_time) < spin_time)
+    {
+      int64_t cur_time = timer_ticks ();
+      if (cur_time != last_time)
+        ti->tick_count++;
+      last_time = cur_time;
+    }
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(cfs-nice) begin
+(cfs-nice) Starting 2 threads...
+(cfs-nice) Sleeping 12 seconds to let threads run, please wait...
+(cfs-nice) Thread at nice 0 received about 75% of the ticks.
+(cfs-nice) Thread at nice 5 received about 24% of the ticks.
+(cfs-nice) end
+EOF
+pass;
@@ -0,0 +1,79 @@
+/* Tests palloc_get_multiple() and palloc_free_multiple() on the
+   buddy allocator.  Blocks of every size from 1 to BLOCK_CNT
+   pages, most of them not a power of two, must not overlap,
+   PAL_ZERO must clear them, and freeing every other block and
+   allocating it again must leave the rest alone.  A block may
+   also be freed in pieces. */
+
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+
+#define BLOCK_CNT 12
+
+static void *blocks[BLOCK_CNT];
+
+/* Allocates block I, of I + 1 pages, and fills it with I. */
+static void
+get_block (int i) 
+{
+  size_t size = (i + 1) * PGSIZE;
+  uint8_t *p = palloc_get_multiple (PAL_ZERO, i + 1);
+  size_t ofs;
+
+  if (p == NULL)
+    fail ("allocating %d pages failed", i + 1);
+  if (pg_ofs (p) != 0)
+    fail ("block of %d pages is not page-aligned", i + 1);
+  for (ofs = 0; ofs < size; ofs++)
+    if (p[ofs] != 0)
+      fail ("block of %d pages is not zeroed", i + 1);
+  memset (p, i, size);
+  blocks[i] = p;
+}
+
+/* Checks that block I still holds what get_block() put in it. */
+static void
+check_block (int i) 
+{
+  size_t size = (i + 1) * PGSIZE;
+  uint8_t *p = blocks[i];
+  size_t ofs;
+
+  for (ofs = 0; ofs < size; ofs++)
+    if (p[ofs] != i)
+      fail ("block of %d pages was overwritten", i + 1);
+}
+
+void
+test_palloc_buddy (void) 
+{
+  uint8_t *p;
+  int i;
+
+  for (i = 0; i < BLOCK_CNT; i++)
+    get_block (i);
+  for (i = 0; i < BLOCK_CNT; i++)
+    check_block (i);
+  msg ("Allocated %d blocks that do not overlap.", BLOCK_CNT);
+
+  for (i = 1; i < BLOCK_CNT; i += 2)
+    palloc_free_multiple (blocks[i], i + 1);
+  for (i = 1; i < BLOCK_CNT; i += 2)
+    get_block (i);
+  for (i = 0; i < BLOCK_CNT; i++)
+    check_block (i);
+  msg ("Freed and reallocated every other block.");
+
+  for (i = 0; i < BLOCK_CNT; i++)
+    palloc_free_multiple (blocks[i], i + 1);
+
+  p = palloc_get_multiple (0, 3);
+  if (p == NULL)
+    fail ("allocating 3 pages failed");
+  palloc_free_page (p);
+  palloc_free_multiple (p + PGSIZE, 2);
+  msg ("Freed a block in pieces.");
+}
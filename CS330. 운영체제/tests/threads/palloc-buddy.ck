@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(palloc-buddy) begin
+(palloc-buddy) Allocated 12 blocks that do not overlap.
+(palloc-buddy) Freed and reallocated every other block.
+(palloc-buddy) Freed a block in pieces.
+(palloc-buddy) end
+EOF
+pass;
@@ -0,0 +1,57 @@
+/* Tests readers-writer locks.  A second reader gets a lock that
+   is already held for reading without waiting.  A writer waits
+   for the reader to leave, donating its priority to it, and
+   with writer preference keeps a later reader out until it is
+   done.  That later reader, of higher priority still, donates
+   through the waiting writer to the reader it waits for. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+static thread_func reader_thread;
+static thread_func writer_thread;
+static struct rwlock rw;
+
+void
+test_rwlock (void) 
+{
+  /* This test does not work with the MLFQS. */
+  ASSERT (!thread_mlfqs);
+
+  /* Make sure our priority is the default. */
+  ASSERT (thread_get_priority () == PRI_DEFAULT);
+
+  rwlock_init (&rw, true);
+  rwlock_read_acquire (&rw);
+  thread_create ("reader 1", PRI_DEFAULT + 1, reader_thread, NULL);
+  thread_create ("writer", PRI_DEFAULT + 2, writer_thread, NULL);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 2, thread_get_priority ());
+  thread_create ("reader 2", PRI_DEFAULT + 3, reader_thread, NULL);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT + 3, thread_get_priority ());
+  msg ("Main thread releases its read lock.");
+  rwlock_release (&rw);
+  msg ("Main thread should have priority %d.  Actual priority: %d.",
+       PRI_DEFAULT, thread_get_priority ());
+}
+
+static void
+reader_thread (void *aux UNUSED) 
+{
+  rwlock_read_acquire (&rw);
+  msg ("%s acquired the lock for reading.", thread_name ());
+  rwlock_release (&rw);
+  msg ("%s released the lock.", thread_name ());
+}
+
+static void
+writer_thread (void *aux UNUSED) 
+{
+  rwlock_write_acquire (&rw);
+  msg ("%s acquired the lock for writing.", thread_name ());
+  rwlock_release (&rw);
+}
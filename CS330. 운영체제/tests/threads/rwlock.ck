@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(rwlock) begin
+(rwlock) reader 1 acquired the lock for reading.
+(rwlock) reader 1 released the lock.
+(rwlock) Main thread should have priority 33.  Actual priority: 33.
+(rwlock) Main thread should have priority 34.  Actual priority: 34.
+(rwlock) Main thread releases its read lock.
+(rwlock) writer acquired the lock for writing.
+(rwlock) reader 2 acquired the lock for reading.
+(rwlock) reader 2 released the lock.
+(rwlock) Main thread should have priority 31.  Actual priority: 31.
+(rwlock) end
+EOF
+pass;
@@ -0,0 +1,101 @@
+/* Tests kmem_cache object caches.  Objects must be distinct,
+   aligned as asked, and constructed.  Once every object is
+   freed, the cache's empty slabs can be reclaimed, and an object
+   that is freed and allocated again comes back in the state it
+   was freed in, without running the constructor again. */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "tests/threads/tests.h"
+#include "threads/slab.h"
+
+#define OBJ_CNT 100
+#define OBJ_ALIGN 64
+#define OBJ_MAGIC 0x0b1ec7
+
+struct obj 
+  {
+    unsigned magic;
+    int id;
+    char pad[200];
+  };
+
+static struct obj *objs[OBJ_CNT];
+static int ctor_cnt;
+
+static void
+obj_ctor (void *obj_) 
+{
+  struct obj *obj = obj_;
+
+  obj->magic = OBJ_MAGIC;
+  obj->id = -1;
+  ctor_cnt++;
+}
+
+void
+test_slab_cache (void) 
+{
+  struct kmem_cache *cache;
+  struct obj *a, *b;
+  int i, cnt;
+
+  cache = kmem_cache_create ("test", sizeof (struct obj), OBJ_ALIGN,
+                             obj_ctor);
+  for (i = 0; i < OBJ_CNT; i++) 
+    {
+      objs[i] = kmem_cache_alloc (cache);
+      if (objs[i] == NULL)
+        fail ("allocating object %d failed", i);
+      if ((uintptr_t) objs[i] % OBJ_ALIGN != 0)
+        fail ("object %d is not aligned", i);
+      if (objs[i]->magic != OBJ_MAGIC || objs[i]->id != -1)
+        fail ("object %d was not constructed", i);
+      objs[i]->id = i;
+    }
+  for (i = 0; i < OBJ_CNT; i++)
+    if (objs[i]->id != i)
+      fail ("object %d was handed out twice", i);
+  if (ctor_cnt < OBJ_CNT)
+    fail ("constructor ran %d times for %d objects", ctor_cnt, OBJ_CNT);
+  msg ("Allocated %d distinct constructed objects.", OBJ_CNT);
+
+  for (i = 0; i < OBJ_CNT; i++) 
+    {
+      objs[i]->id = -1;
+      kmem_cache_free (cache, objs[i]);
+    }
+  if (kmem_cache_reclaim (cache) == 0)
+    fail ("no empty slab to reclaim after freeing every object");
+  if (kmem_cache_reclaim (cache) != 0)
+    fail ("empty slabs left after reclaiming");
+  msg ("Reclaimed the empty slabs.");
+
+  a = kmem_cache_alloc (cache);
+  if (a == NULL)
+    fail ("allocating after reclaiming failed");
+  cnt = ctor_cnt;
+  a->id = 7;
+  kmem_cache_free (cache, a);
+  b = kmem_cache_alloc (cache);
+  if (b != a || b->magic != OBJ_MAGIC || b->id != 7)
+    fail ("freed object did not come back as it was freed");
+  if (ctor_cnt != cnt)
+    fail ("constructor ran again for a reused object");
+  msg ("Reused a freed object without constructing it again.");
+
+  a = kmem_cache_zalloc (cache);
+  if (a == NULL)
+    fail ("kmem_cache_zalloc failed");
+  for (i = 0; i < (int) sizeof *a; i++)
+    if (((uint8_t *) a)[i] != 0)
+      fail ("kmem_cache_zalloc did not zero the object");
+  msg ("kmem_cache_zalloc returned a zeroed object.");
+
+  obj_ctor (a);
+  b->id = -1;
+  kmem_cache_free (cache, a);
+  kmem_cache_free (cache, b);
+  kmem_cache_reclaim (cache);
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(slab-cache) begin
+(slab-cache) Allocated 100 distinct constructed objects.
+(slab-cache) Reclaimed the empty slabs.
+(slab-cache) Reused a freed object without constructing it again.
+(slab-cache) kmem_cache_zalloc returned a zeroed object.
+(slab-cache) end
+EOF
+pass;
@@ -0,0 +1,161 @@
+/* Tests workqueues.  Delayed works run in the order they fall
+   due, not the order they were queued in, and none runs before
+   its tick.  Queued and delayed works can be cancelled before
+   they run.  flush_work() on a running work waits for it to
+   finish, and on a work that queues itself again waits for the
+   last run. */
+
+#include <stdio.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/workqueue.h"
+#include "devices/timer.h"
+
+static struct workqueue *wq;
+
+/* Delayed works, in the order they are queued. */
+#define DELAYED_CNT 3
+static const int64_t delays[DELAYED_CNT] = {30, 10, 20};
+static struct work delayed[DELAYED_CNT];
+static int64_t ran_at[DELAYED_CNT];
+static int order[DELAYED_CNT];
+static int order_cnt;
+
+static struct work blocker, opener, victim, late, again;
+static struct semaphore started, gate;
+static bool blocker_done;
+static bool victim_ran;
+static int again_cnt;
+
+static work_func delayed_work;
+static work_func blocker_work;
+static work_func opener_work;
+static work_func victim_work;
+static work_func again_work;
+
+void
+test_workqueue (void)
+{
+  enum intr_level old_level;
+  int64_t start, due;
+  int i;
+
+  wq = workqueue_create ("test-wq", 1, PRI_DEFAULT);
+  if (wq == NULL)
+    fail ("workqueue_create failed");
+
+  /* Delayed works run in order of their due ticks. */
+  old_level = intr_disable ();
+  start = timer_ticks ();
+  for (i = 0; i < DELAYED_CNT; i++)
+    {
+      work_init (&delayed[i], delayed_work, (void *) (intptr_t) i);
+      queue_delayed_work (wq, &delayed[i], delays[i]);
+    }
+  due = workqueue_next_due ();
+  intr_set_level (old_level);
+  if (due != start + 10)
+    fail ("next due tick is %lld, expected %lld", due, start + 10);
+
+  timer_sleep (40);
+  flush_workqueue (wq);
+  if (order_cnt != DELAYED_CNT)
+    fail ("%d of %d delayed works ran", order_cnt, DELAYED_CNT);
+  for (i = 0; i < DELAYED_CNT; i++)
+    if (ran_at[i] < start + delays[i])
+      fail ("work delayed %lld ticks ran after %lld",
+            delays[i], ran_at[i] - start);
+  msg ("Delayed works ran in order: %d %d %d.",
+       order[0], order[1], order[2]);
+
+  /* A delayed work can be cancelled before it falls due. */
+  work_init (&late, victim_work, NULL);
+  old_level = intr_disable ();
+  queue_delayed_work (wq, &late, 1000);
+  due = timer_ticks () + 1000;
+  intr_set_level (old_level);
+  if (!cancel_work_sync (&late))
+    fail ("cancelling a delayed work found it idle");
+  if (cancel_work (&late))
+    fail ("cancelling a cancelled work found it pending");
+  old_level = intr_disable ();
+  if (workqueue_next_due () == due)
+    fail ("cancelled work is still delayed");
+  intr_set_level (old_level);
+  msg ("Cancelled a delayed work.");
+
+  /* Keep the only worker busy, so that the next work stays queued. */
+  sema_init (&started, 0);
+  sema_init (&gate, 0);
+  work_init (&blocker, blocker_work, NULL);
+  queue_work (wq, &blocker);
+  sema_down (&started);
+
+  work_init (&victim, victim_work, NULL);
+  if (!queue_work (wq, &victim))
+    fail ("queueing an idle work failed");
+  if (queue_work (wq, &victim))
+    fail ("queueing a queued work again succeeded");
+  if (!cancel_work_sync (&victim))
+    fail ("cancelling a queued work found it idle");
+  msg ("Cancelled a queued work.");
+
+  /* system_wq opens the gate while we wait for the blocker. */
+  work_init (&opener, opener_work, NULL);
+  schedule_delayed_work (&opener, 10);
+  flush_work (&blocker);
+  if (!blocker_done)
+    fail ("flush_work returned while the work was running");
+  msg ("Flushed a running work.");
+
+  /* A work that queues itself again is flushed through its
+     last run. */
+  work_init (&again, again_work, NULL);
+  queue_work (wq, &again);
+  flush_work (&again);
+  msg ("Self-queueing work ran %d times.", again_cnt);
+
+  flush_work (&opener);
+  workqueue_destroy (wq);
+  if (victim_ran)
+    fail ("a cancelled work ran");
+}
+
+static void
+delayed_work (void *aux)
+{
+  int i = (intptr_t) aux;
+
+  ran_at[i] = timer_ticks ();
+  order[order_cnt++] = delays[i];
+}
+
+static void
+blocker_work (void *aux UNUSED)
+{
+  sema_up (&started);
+  sema_down (&gate);
+  blocker_done = true;
+}
+
+static void
+opener_work (void *aux UNUSED)
+{
+  sema_up (&gate);
+}
+
+static void
+victim_work (void *aux UNUSED)
+{
+  victim_ran = true;
+}
+
+static void
+again_work (void *aux UNUSED)
+{
+  if (++again_cnt < 5)
+    queue_work (wq, &again);
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(workqueue) begin
+(workqueue) Delayed works ran in order: 10 20 30.
+(workqueue) Cancelled a delayed work.
+(workqueue) Cancelled a queued work.
+(workqueue) Flushed a running work.
+(workqueue) Self-queueing work ran 5 times.
+(workqueue) end
+EOF
+pass;
@@ -0,0 +1,46 @@
+/* The main thread exits while one thread made with clone() is
+   blocked in the kernel reading the keyboard, which never gets a
+   key, and another is blocked joining that thread.  Both waits
+   must be cut short, so that the process can finish exiting. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define STACK_SIZE 4096
+
+static char stacks[2][STACK_SIZE] __attribute__ ((aligned (16)));
+static volatile int started;
+static pid_t reader_tid;
+
+static int
+reader (void *aux UNUSED) 
+{
+  char c;
+
+  __atomic_fetch_add (&started, 1, __ATOMIC_SEQ_CST);
+  read (STDIN_FILENO, &c, 1);
+  fail ("read returned to user mode");
+  NOT_REACHED ();
+}
+
+static int
+joiner (void *aux UNUSED) 
+{
+  __atomic_fetch_add (&started, 1, __ATOMIC_SEQ_CST);
+  join (reader_tid);
+  fail ("join returned to user mode");
+  NOT_REACHED ();
+}
+
+void
+test_main (void) 
+{
+  reader_tid = clone (reader, NULL, stacks[0] + STACK_SIZE);
+  CHECK (reader_tid > 0, "clone reader");
+  CHECK (clone (joiner, NULL, stacks[1] + STACK_SIZE) > 0, "clone joiner");
+  while (started < 2)
+    continue;
+  msg ("exiting with both threads blocked");
+}
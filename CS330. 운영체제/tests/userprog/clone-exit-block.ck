@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(clone-exit-block) begin
+(clone-exit-block) clone reader
+(clone-exit-block) clone joiner
+(clone-exit-block) exiting with both threads blocked
+(clone-exit-block) end
+clone-exit-block: exit(0)
+EOF
+pass;
@@ -0,0 +1,41 @@
+/* The main thread exits while one thread made with clone() sleeps
+   on a futex that is never woken and another spins in user mode.
+   Both must be killed, so that the process can finish exiting. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define STACK_SIZE 4096
+
+static char stacks[2][STACK_SIZE] __attribute__ ((aligned (16)));
+static volatile int started;
+static int never;
+
+static int
+sleeper (void *aux UNUSED) 
+{
+  __atomic_fetch_add (&started, 1, __ATOMIC_SEQ_CST);
+  for (;;)
+    futex_wait (&never, 0);
+  NOT_REACHED ();
+}
+
+static int
+spinner (void *aux UNUSED) 
+{
+  __atomic_fetch_add (&started, 1, __ATOMIC_SEQ_CST);
+  for (;;)
+    continue;
+  NOT_REACHED ();
+}
+
+void
+test_main (void) 
+{
+  CHECK (clone (sleeper, NULL, stacks[0] + STACK_SIZE) > 0, "clone sleeper");
+  CHECK (clone (spinner, NULL, stacks[1] + STACK_SIZE) > 0, "clone spinner");
+  while (started < 2)
+    continue;
+  msg ("exiting with both threads running");
+}
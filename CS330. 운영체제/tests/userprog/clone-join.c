@@ -0,0 +1,35 @@
+/* Starts a thread with clone() and joins it.  The thread shares
+   the process's memory, and its return value is what join()
+   returns.  A thread can be joined only once, and join() refuses
+   tids that are not threads of the process. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define STACK_SIZE 4096
+
+static char stack[STACK_SIZE] __attribute__ ((aligned (16)));
+static int shared;
+
+static int
+thread_func (void *aux) 
+{
+  msg ("thread got %d", *(int *) aux);
+  shared = *(int *) aux + 1;
+  return 42;
+}
+
+void
+test_main (void) 
+{
+  int arg = 7;
+  pid_t tid;
+
+  tid = clone (thread_func, &arg, stack + STACK_SIZE);
+  CHECK (tid > 0, "clone");
+  msg ("join = %d", join (tid));
+  msg ("shared = %d", shared);
+  CHECK (join (tid) == -1, "second join refused");
+  CHECK (join (tid + 1000) == -1, "join of an unknown tid refused");
+}
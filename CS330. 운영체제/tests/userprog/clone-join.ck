@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(clone-join) begin
+(clone-join) clone
+(clone-join) thread got 7
+(clone-join) join = 42
+(clone-join) shared = 8
+(clone-join) second join refused
+(clone-join) join of an unknown tid refused
+(clone-join) end
+clone-join: exit(0)
+EOF
+pass;
@@ -0,0 +1,61 @@
+/* Several threads made with clone() add to a shared counter under
+   a futex-based mutex.  Each update reads the counter, spins for a
+   while and then writes it back, so that timer interrupts preempt
+   threads inside the critical section and the others have to
+   sleep on the mutex.  No update may be lost. */
+
+#include <sync.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 4
+#define ITER_CNT 200
+#define SPIN_CNT 10000
+#define STACK_SIZE 4096
+
+static char stacks[THREAD_CNT][STACK_SIZE] __attribute__ ((aligned (16)));
+static struct mutex mutex = MUTEX_INITIALIZER;
+static int counter;
+
+static int
+thread_func (void *aux) 
+{
+  int id = (int) (long) aux;
+
+  for (int i = 0; i < ITER_CNT; i++) 
+    {
+      int value;
+
+      mutex_lock (&mutex);
+      value = counter;
+      for (volatile int j = 0; j < SPIN_CNT; j++)
+        continue;
+      counter = value + 1;
+      mutex_unlock (&mutex);
+    }
+  return id;
+}
+
+void
+test_main (void) 
+{
+  pid_t tids[THREAD_CNT];
+  int i;
+
+  for (i = 0; i < THREAD_CNT; i++) 
+    {
+      tids[i] = clone (thread_func, (void *) (long) i,
+                       stacks[i] + STACK_SIZE);
+      if (tids[i] <= 0)
+        fail ("clone %d failed", i);
+    }
+  msg ("started %d threads", THREAD_CNT);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    if (join (tids[i]) != i)
+      fail ("join of thread %d returned the wrong status", i);
+  msg ("joined %d threads", THREAD_CNT);
+
+  CHECK (counter == THREAD_CNT * ITER_CNT, "counter = %d", counter);
+}
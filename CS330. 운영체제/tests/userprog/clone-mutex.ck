@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(clone-mutex) begin
+(clone-mutex) started 4 threads
+(clone-mutex) joined 4 threads
+(clone-mutex) counter = 800
+(clone-mutex) end
+clone-mutex: exit(0)
+EOF
+pass;
@@ -0,0 +1,32 @@
+/* Checks futex_wait() and futex_wake() from a single thread.
+   futex_wait() must return at once when the int no longer holds
+   the expected value or the address is bad, and futex_wake()
+   must report that nobody was woken.  Then checks that a mutex
+   can be taken and released without sleeping. */
+
+#include <sync.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static int word = 1;
+
+void
+test_main (void) 
+{
+  struct mutex m = MUTEX_INITIALIZER;
+
+  CHECK (futex_wait (&word, 0) == -1, "futex_wait on a changed value");
+  CHECK (futex_wait ((int *) ((char *) &word + 1), 1) == -1,
+         "futex_wait on a misaligned address");
+  CHECK (futex_wait ((int *) 0x8004000000, 0) == -1,
+         "futex_wait on a kernel address");
+  CHECK (futex_wake (&word, 1) == 0, "futex_wake with no waiters");
+
+  CHECK (mutex_trylock (&m), "mutex_trylock on a free mutex");
+  CHECK (!mutex_trylock (&m), "mutex_trylock on a held mutex");
+  mutex_unlock (&m);
+  mutex_lock (&m);
+  msg ("mutex_lock after unlock");
+  mutex_unlock (&m);
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(futex-wait) begin
+(futex-wait) futex_wait on a changed value
+(futex-wait) futex_wait on a misaligned address
+(futex-wait) futex_wait on a kernel address
+(futex-wait) futex_wake with no waiters
+(futex-wait) mutex_trylock on a free mutex
+(futex-wait) mutex_trylock on a held mutex
+(futex-wait) mutex_lock after unlock
+(futex-wait) end
+futex-wait: exit(0)
+EOF
+pass;
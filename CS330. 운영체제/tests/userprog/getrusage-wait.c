@@ -0,0 +1,48 @@
+/* Checks that getrusage(RUSAGE_CHILDREN) counts the CPU time of a
+   child only once the child has been waited for, and that the
+   time a child spins in user mode is counted as user time. */
+
+#include <rusage.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Returns the timer ticks the calling process has run in user
+   mode. */
+static long long
+user_ticks (void) 
+{
+  struct rusage usage;
+
+  if (getrusage (RUSAGE_SELF, &usage) != 0)
+    fail ("getrusage(RUSAGE_SELF) failed");
+  return usage.user_ticks;
+}
+
+void
+test_main (void) 
+{
+  struct rusage usage;
+  pid_t pid;
+
+  CHECK (getrusage (RUSAGE_CHILDREN, &usage) == 0
+         && usage.user_ticks == 0 && usage.kernel_ticks == 0,
+         "no child waited for yet");
+
+  if ((pid = fork ("child")))
+    {
+      msg ("wait(child) = %d", wait (pid));
+      CHECK (getrusage (RUSAGE_CHILDREN, &usage) == 0
+             && usage.user_ticks >= 2,
+             "child's user ticks counted");
+      CHECK (getrusage (12345, &usage) == -1, "getrusage(12345) refused");
+    }
+  else
+    {
+      /* Spin in user mode for at least two timer ticks. */
+      while (user_ticks () < 2)
+        for (volatile int i = 0; i < 100000; i++)
+          continue;
+      exit (0);
+    }
+}
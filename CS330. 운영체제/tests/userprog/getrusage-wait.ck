@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(getrusage-wait) begin
+(getrusage-wait) no child waited for yet
+child: exit(0)
+(getrusage-wait) wait(child) = 0
+(getrusage-wait) child's user ticks counted
+(getrusage-wait) getrusage(12345) refused
+(getrusage-wait) end
+getrusage-wait: exit(0)
+EOF
+pass;
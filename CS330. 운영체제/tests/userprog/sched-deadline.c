@@ -0,0 +1,33 @@
+/* Checks admission control in sched_deadline().  Parameters that
+   make no sense are refused, and so is a reservation that would
+   take the total bandwidth of the EDF threads over the limit.  A
+   process that exits gives its bandwidth back. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void) 
+{
+  pid_t pid;
+
+  CHECK (sched_deadline (20, 10, 100) == -1, "runtime > deadline refused");
+  CHECK (sched_deadline (10, 100, 50) == -1, "deadline > period refused");
+  CHECK (sched_deadline (50, 100, 100) == 0, "reserve 50%% of the CPU");
+
+  if ((pid = fork ("child")))
+    {
+      msg ("wait(child) = %d", wait (pid));
+      CHECK (sched_deadline (90, 100, 100) == 0,
+             "grow to 90%% once the child is gone");
+      CHECK (sched_deadline (0, 0, 0) == 0, "leave the EDF class");
+    }
+  else
+    {
+      CHECK (sched_deadline (40, 100, 100) == 0, "child reserves 40%%");
+      CHECK (sched_deadline (60, 100, 100) == -1,
+             "child cannot grow to 60%%");
+      exit (0);
+    }
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(sched-deadline) begin
+(sched-deadline) runtime > deadline refused
+(sched-deadline) deadline > period refused
+(sched-deadline) reserve 50% of the CPU
+(sched-deadline) child reserves 40%
+(sched-deadline) child cannot grow to 60%
+child: exit(0)
+(sched-deadline) wait(child) = 0
+(sched-deadline) grow to 90% once the child is gone
+(sched-deadline) leave the EDF class
+(sched-deadline) end
+sched-deadline: exit(0)
+EOF
+pass;
@@ -11,6 +11,7 @@
 #include "devices/kbd.h"
 #include "devices/input.h"
 #include "devices/serial.h"
+#include "devices/hrtimer.h"
 #include "devices/timer.h"
 #include "devices/vga.h"
 #include "threads/interrupt.h"
@@ -20,6 +21,10 @@
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/sched-trace.h"
+#include "threads/slab.h"
+#include "threads/softirq.h"
+#include "threads/workqueue.h"
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -103,8 +108,11 @@ main (void) {
 #endif
 	/* Start thread scheduler and enable interrupts. */
 	thread_start ();
+	softirq_init ();
+	workqueue_init ();
 	serial_init_queue ();
 	timer_calibrate ();
+	hrtimer_init ();
 
 #ifdef FILESYS
 	/* Initialize file system. */
@@ -221,6 +229,12 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-cfs"))
+			thread_cfs = true;
+		else if (!strcmp (name, "-tickless"))
+			timer_tickless = true;
+		else if (!strcmp (name, "-sched-trace"))
+			sched_trace_enabled = true;
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
@@ -230,6 +244,8 @@ parse_options (char **argv) {
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
 	}
+	if (thread_mlfqs && thread_cfs)
+		PANIC ("-mlfqs and -cfs cannot be used together");
 
 	return argv;
 }
@@ -326,6 +342,9 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -cfs               Use completely fair (vruntime) scheduler.\n"
+			"  -tickless          Stop the timer tick while the CPU is idle.\n"
+			"  -sched-trace       Record scheduler events and latencies.\n"
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
 #endif
@@ -354,6 +373,9 @@ static void
 print_stats (void) {
 	timer_print_stats ();
 	thread_print_stats ();
+	lock_print_stats ();
+	kmem_cache_print_stats ();
+	sched_trace_print_stats ();
 #ifdef FILESYS
 	disk_print_stats ();
 #endif
@@ -8,11 +8,13 @@
 #include "threads/io.h"
 #include "threads/thread.h"
 #include "threads/mmu.h"
+#include "threads/softirq.h"
 #include "threads/vaddr.h"
 #include "devices/timer.h"
 #include "intrinsic.h"
 #ifdef USERPROG
 #include "userprog/gdt.h"
+#include "userprog/process.h"
 #endif
 
 /* Number of x86_64 interrupts. */
@@ -99,10 +101,14 @@ static const char *intr_names[INTR_CNT];
    pre-empted.  Handlers for external interrupts also may not
    sleep, although they may invoke intr_yield_on_return() to
    request that a new process be scheduled just before the
-   interrupt returns. */
+   interrupt returns.  Work that can wait until interrupts are
+   back on should be deferred with softirq_raise(). */
 static bool in_external_intr;   /* Are we processing an external interrupt? */
 static bool yield_on_return;    /* Should we yield on interrupt return? */
 
+/* Vectors raised by the local APIC, handled as external. */
+static bool local_intr[INTR_CNT];
+
 /* Programmable Interrupt Controller helpers. */
 static void pic_init (void);
 static void pic_end_of_interrupt (int irq);
@@ -231,6 +237,19 @@ intr_register_ext (uint8_t vec_no, intr_handler_func *handler,
 	register_handler (vec_no, 0, INTR_OFF, handler, name);
 }
 
+/* Registers interrupt VEC_NO, raised by this CPU's local APIC,
+   to invoke HANDLER, which is named NAME for debugging purposes.
+   It is handled like an external interrupt, except that the PIC
+   knows nothing of it: HANDLER must acknowledge it on the local
+   APIC itself. */
+void
+intr_register_local (uint8_t vec_no, intr_handler_func *handler,
+		const char *name) {
+	ASSERT (vec_no >= 0x30);
+	register_handler (vec_no, 0, INTR_OFF, handler, name);
+	local_intr[vec_no] = true;
+}
+
 /* Registers internal interrupt VEC_NO to invoke HANDLER, which
    is named NAME for debugging purposes.  The interrupt handler
    will be invoked with interrupt status LEVEL.
@@ -337,7 +356,8 @@ intr_handler (struct intr_frame *frame) {
 	   We only handle one at a time (so interrupts must be off)
 	   and they need to be acknowledged on the PIC (see below).
 	   An external interrupt handler cannot sleep. */
-	external = frame->vec_no >= 0x20 && frame->vec_no < 0x30;
+	external = (frame->vec_no >= 0x20 && frame->vec_no < 0x30)
+		|| local_intr[frame->vec_no];
 	if (external) {
 		ASSERT (intr_get_level () == INTR_OFF);
 		ASSERT (!intr_context ());
@@ -367,11 +387,19 @@ intr_handler (struct intr_frame *frame) {
 		ASSERT (intr_context ());
 
 		in_external_intr = false;
-		pic_end_of_interrupt (frame->vec_no);
+		if (frame->vec_no < 0x30)
+			pic_end_of_interrupt (frame->vec_no);
 
-		if (yield_on_return)
+		/* 미뤄둔 작업은 인터럽트를 켠 채로 실행 */
+		if (softirq_run (yield_on_return))
 			thread_yield ();
 	}
+
+#ifdef USERPROG
+	/* 끝나는 중인 프로세스의 스레드는 유저 모드로 돌려보내지 않음 */
+	if (frame->cs == SEL_UCSEG)
+		process_exit_if_dying ();
+#endif
 }
 
 /* Dumps interrupt frame F to the console, for debugging. */
@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "threads/init.h"
+#include "threads/interrupt.h"
 #include "threads/loader.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
@@ -24,12 +25,26 @@
 
    By default, half of system RAM is given to the kernel pool and
    half to the user pool.  That should be huge overkill for the
-   kernel pool, but that's just fine for demonstration purposes. */
+   kernel pool, but that's just fine for demonstration purposes.
 
-/* A memory pool. */
+   Within a pool, free pages are kept by a binary buddy allocator.
+   A block of order K is 2**K pages whose index in the pool is a
+   multiple of 2**K; its buddy is the other half of the order K+1
+   block that contains it.  Each order has a list of free blocks,
+   linked through the first page of each block, so allocating
+   and freeing take O(log n) list operations instead of a scan of
+   the whole pool.  A request that is not a power of two takes
+   the next larger block and gives its unused tail back. */
+
+/* Number of buddy orders: blocks of 1 to 2**(BUDDY_ORDERS-1) pages. */
+#define BUDDY_ORDERS 20
+
+/* A memory pool.  Only touched with interrupts off. */
 struct pool {
-	struct lock lock;               /* Mutual exclusion. */
 	struct bitmap *used_map;        /* Bitmap of free pages. */
+	uint8_t *order_map;             /* Per page: 1 + order of the free
+	                                   block it starts, or 0. */
+	struct list free_lists[BUDDY_ORDERS]; /* Free blocks by order. */
 	uint8_t *base;                  /* Base of pool. */
 };
 
@@ -42,6 +57,10 @@ static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end);
 
 static bool page_from_pool (const struct pool *, void *page);
+static void pool_release (struct pool *, size_t page_idx, size_t page_cnt);
+static size_t buddy_alloc (struct pool *, size_t page_cnt);
+static void buddy_free_range (struct pool *, size_t page_idx,
+		size_t page_cnt);
 
 /* multiboot info */
 struct multiboot_info {
@@ -223,12 +242,12 @@ split:
 			page_idx = pg_no (start) - pg_no (pool->base);
 			if ((uint64_t) pool_end < end) {
 				page_cnt = ((uint64_t) pool_end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				pool_release (pool, page_idx, page_cnt);
 				start = (uint64_t) pool_end;
 				goto split;
 			} else {
 				page_cnt = ((uint64_t) end - start) / PGSIZE;
-				bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+				pool_release (pool, page_idx, page_cnt);
 			}
 		}
 	}
@@ -262,12 +281,21 @@ palloc_init (void) {
 void *
 palloc_get_multiple (enum palloc_flags flags, size_t page_cnt) {
 	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
-
-	lock_acquire (&pool->lock);
-	size_t page_idx = bitmap_scan_and_flip (pool->used_map, 0, page_cnt, false);
-	lock_release (&pool->lock);
+	enum intr_level old_level;
+	size_t page_idx;
 	void *pages;
 
+	if (page_cnt == 0)
+		return NULL;
+
+	old_level = intr_disable ();
+	page_idx = buddy_alloc (pool, page_cnt);
+	if (page_idx != BITMAP_ERROR) {
+		ASSERT (bitmap_none (pool->used_map, page_idx, page_cnt));
+		bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+	}
+	intr_set_level (old_level);
+
 	if (page_idx != BITMAP_ERROR)
 		pages = pool->base + PGSIZE * page_idx;
 	else
@@ -296,11 +324,13 @@ palloc_get_page (enum palloc_flags flags) {
 	return palloc_get_multiple (flags, 1);
 }
 
-/* Frees the PAGE_CNT pages starting at PAGES. */
+/* Frees the PAGE_CNT pages starting at PAGES.
+   May be called with interrupts off. */
 void
 palloc_free_multiple (void *pages, size_t page_cnt) {
 	struct pool *pool;
 	size_t page_idx;
+	enum intr_level old_level;
 
 	ASSERT (pg_ofs (pages) == 0);
 	if (pages == NULL || page_cnt == 0)
@@ -318,8 +348,10 @@ palloc_free_multiple (void *pages, size_t page_cnt) {
 #ifndef NDEBUG
 	memset (pages, 0xcc, PGSIZE * page_cnt);
 #endif
-	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
-	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+
+	old_level = intr_disable ();
+	pool_release (pool, page_idx, page_cnt);
+	intr_set_level (old_level);
 }
 
 /* Frees the page at PAGE. */
@@ -336,15 +368,22 @@ init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
      and subtract it from the pool's size. */
 	uint64_t pgcnt = (end - start) / PGSIZE;
 	size_t bm_pages = DIV_ROUND_UP (bitmap_buf_size (pgcnt), PGSIZE) * PGSIZE;
+	size_t om_pages = DIV_ROUND_UP (pgcnt, PGSIZE) * PGSIZE;
+	int order;
 
-	lock_init(&p->lock);
 	p->used_map = bitmap_create_in_buf (pgcnt, *bm_base, bm_pages);
 	p->base = (void *) start;
 
 	// Mark all to unusable.
 	bitmap_set_all(p->used_map, true);
 
-	*bm_base += bm_pages;
+	/* order_map은 bitmap 바로 뒤에 둠 */
+	p->order_map = (uint8_t *) *bm_base + bm_pages;
+	memset (p->order_map, 0, pgcnt);
+	for (order = 0; order < BUDDY_ORDERS; order++)
+		list_init (&p->free_lists[order]);
+
+	*bm_base += bm_pages + om_pages;
 }
 
 /* Returns true if PAGE was allocated from POOL,
@@ -356,3 +395,104 @@ page_from_pool (const struct pool *pool, void *page) {
 	size_t end_page = start_page + bitmap_size (pool->used_map);
 	return page_no >= start_page && page_no < end_page;
 }
+
+/* Returns the free-list element kept in page PAGE_IDX of POOL. */
+static struct list_elem *
+page_elem (struct pool *pool, size_t page_idx) {
+	return (struct list_elem *) (pool->base + PGSIZE * page_idx);
+}
+
+/* Returns the index in POOL of the page holding list element E. */
+static size_t
+elem_page (struct pool *pool, struct list_elem *e) {
+	return pg_no (e) - pg_no (pool->base);
+}
+
+/* Puts the free block of 2**ORDER pages at PAGE_IDX on its free
+   list. */
+static void
+buddy_push (struct pool *pool, size_t page_idx, int order) {
+	pool->order_map[page_idx] = order + 1;
+	list_push_front (&pool->free_lists[order], page_elem (pool, page_idx));
+}
+
+/* Frees the block of 2**ORDER pages at PAGE_IDX, merging it with
+   its buddy for as long as the buddy is free too. */
+static void
+buddy_free (struct pool *pool, size_t page_idx, int order) {
+	size_t pool_size = bitmap_size (pool->used_map);
+
+	while (order < BUDDY_ORDERS - 1) {
+		size_t buddy = page_idx ^ ((size_t) 1 << order);
+
+		/* 풀 밖이거나 같은 order로 통째로 비어 있지 않으면 멈춤 */
+		if (buddy + ((size_t) 1 << order) > pool_size
+				|| pool->order_map[buddy] != order + 1)
+			break;
+		list_remove (page_elem (pool, buddy));
+		pool->order_map[buddy] = 0;
+		if (buddy < page_idx)
+			page_idx = buddy;
+		order++;
+	}
+	buddy_push (pool, page_idx, order);
+}
+
+/* Frees the PAGE_CNT pages at PAGE_IDX, which need not be a
+   buddy block, as the largest aligned blocks that cover them. */
+static void
+buddy_free_range (struct pool *pool, size_t page_idx, size_t page_cnt) {
+	while (page_cnt > 0) {
+		int order = 0;
+
+		while (order < BUDDY_ORDERS - 1
+				&& (page_idx & (((size_t) 2 << order) - 1)) == 0
+				&& ((size_t) 2 << order) <= page_cnt)
+			order++;
+		buddy_free (pool, page_idx, order);
+		page_idx += (size_t) 1 << order;
+		page_cnt -= (size_t) 1 << order;
+	}
+}
+
+/* Takes PAGE_CNT contiguous pages out of POOL's free lists and
+   returns the index of the first, or BITMAP_ERROR if no free
+   block is big enough. */
+static size_t
+buddy_alloc (struct pool *pool, size_t page_cnt) {
+	int order = 0, k;
+	size_t page_idx;
+
+	while (((size_t) 1 << order) < page_cnt)
+		if (++order == BUDDY_ORDERS)
+			return BITMAP_ERROR;
+
+	for (k = order; k < BUDDY_ORDERS; k++)
+		if (!list_empty (&pool->free_lists[k]))
+			break;
+	if (k == BUDDY_ORDERS)
+		return BITMAP_ERROR;
+
+	page_idx = elem_page (pool, list_pop_front (&pool->free_lists[k]));
+	pool->order_map[page_idx] = 0;
+
+	/* 큰 블록을 반으로 나누며 뒤쪽 절반을 돌려놓음 */
+	while (k > order) {
+		k--;
+		buddy_push (pool, page_idx + ((size_t) 1 << k), k);
+	}
+
+	/* 2의 거듭제곱이 아닌 요청은 남는 꼬리를 돌려놓음 */
+	buddy_free_range (pool, page_idx + page_cnt,
+			((size_t) 1 << order) - page_cnt);
+	return page_idx;
+}
+
+/* Marks the PAGE_CNT allocated pages at PAGE_IDX in POOL free.
+   The caller must hold POOL's lock, or be initializing it. */
+static void
+pool_release (struct pool *pool, size_t page_idx, size_t page_cnt) {
+	ASSERT (bitmap_all (pool->used_map, page_idx, page_cnt));
+	bitmap_set_multiple (pool->used_map, page_idx, page_cnt, false);
+	buddy_free_range (pool, page_idx, page_cnt);
+}
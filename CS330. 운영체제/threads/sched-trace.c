@@ -0,0 +1,154 @@
+#include "threads/sched-trace.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+#include "intrinsic.h"
+
+/* Scheduler event tracing.
+
+   Scheduler events are recorded into a ring buffer, stamped with
+   the time stamp counter.  The newest
+   SCHED_TRACE_SIZE events survive; older ones are overwritten.
+   From the same events two latency histograms are kept: the time
+   from thread_unblock() until the thread runs, and the time any
+   thread spends in a run queue.  Both count TSC cycles in power
+   of 2 buckets, so that tail latency shows up without having to
+   keep every sample.
+
+   Tracing is off unless the kernel is started with -sched-trace.
+   The histograms are printed at power off, and sched_trace_dump()
+   prints the raw events whenever it is called. */
+
+/* -sched-trace: record scheduler events? */
+bool sched_trace_enabled;
+
+/* TSC and timer ticks at sched_trace_init(), to estimate the TSC
+   rate when printing. */
+static uint64_t start_tsc;
+static int64_t start_ticks;
+
+/* Events and histograms.  Only written with interrupts off, so
+   recording needs no lock.  Readers may see an event that is being
+   overwritten. */
+static struct sched_trace trace;
+
+static const char *event_names[SCHED_EVENT_CNT] = {
+	[SCHED_SWITCH_IN] = "switch-in",
+	[SCHED_SWITCH_OUT] = "switch-out",
+	[SCHED_BLOCK] = "block",
+	[SCHED_UNBLOCK] = "unblock",
+	[SCHED_DONATE] = "donate",
+	[SCHED_SLEEP] = "sleep",
+	[SCHED_WAKEUP] = "wakeup",
+};
+
+static void hist_add (uint64_t hist[], uint64_t cycles);
+static void print_hist (const char *name, const uint64_t hist[]);
+
+/* Starts the clock that sched_trace_print_stats() uses to convert
+   TSC cycles into time. */
+void
+sched_trace_init (void) {
+	start_tsc = rdtsc ();
+	start_ticks = timer_ticks ();
+}
+
+/* Records event TYPE about thread T in the ring buffer, and updates the latency histograms.  Must be called with
+   interrupts off.  Use the sched_trace() wrapper, which skips the
+   call when tracing is disabled. */
+void
+sched_trace_record (enum sched_event_type type, struct thread *t) {
+	uint64_t now = rdtsc ();
+	struct sched_trace *tr = &trace;
+	struct sched_event *e;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (type < SCHED_EVENT_CNT);
+
+	e = &tr->ring[tr->head++ % SCHED_TRACE_SIZE];
+	e->tsc = now;
+	e->tid = t->tid;
+	e->type = type;
+	e->priority = t->priority;
+
+	switch (type) {
+		case SCHED_UNBLOCK:
+			t->ready_tsc = now;
+			t->ready_woken = true;
+			break;
+
+		case SCHED_SWITCH_OUT:
+			/* 선점되거나 양보한 스레드는 여기서부터 대기 */
+			if (t->status == THREAD_READY) {
+				t->ready_tsc = now;
+				t->ready_woken = false;
+			}
+			break;
+
+		case SCHED_SWITCH_IN:
+			if (t->ready_tsc != 0) {
+				hist_add (tr->runq_hist, now - t->ready_tsc);
+				if (t->ready_woken)
+					hist_add (tr->wakeup_hist, now - t->ready_tsc);
+				t->ready_tsc = 0;
+			}
+			break;
+
+		default:
+			break;
+	}
+}
+
+/* Prints the latency histograms. */
+void
+sched_trace_print_stats (void) {
+	int64_t ticks;
+
+	if (!sched_trace_enabled)
+		return;
+
+	ticks = timer_ticks () - start_ticks;
+	if (ticks > 0)
+		printf ("Sched: ~%"PRIu64" TSC cycles per ms\n",
+				(rdtsc () - start_tsc) / ticks / (1000 / TIMER_FREQ));
+	print_hist ("wakeup-to-run latency", trace.wakeup_hist);
+	print_hist ("run queue wait", trace.runq_hist);
+}
+
+/* Prints the events in the ring buffer, oldest first.  Events
+   recorded while printing may overwrite the ones not yet printed. */
+void
+sched_trace_dump (void) {
+	uint64_t head = trace.head;
+	uint64_t n = head > SCHED_TRACE_SIZE ? head - SCHED_TRACE_SIZE : 0;
+
+	printf ("Sched: %"PRIu64" events\n", head);
+	for (; n < head; n++) {
+		struct sched_event *e = &trace.ring[n % SCHED_TRACE_SIZE];
+		printf ("  %20"PRIu64" %-10s tid %d pri %d\n", e->tsc,
+				e->type < SCHED_EVENT_CNT ? event_names[e->type] : "?",
+				e->tid, e->priority);
+	}
+}
+
+/* Adds a sample of CYCLES to HIST. */
+static void
+hist_add (uint64_t hist[], uint64_t cycles) {
+	int b = cycles != 0 ? 63 - __builtin_clzll (cycles) : 0;
+
+	if (b >= SCHED_HIST_BUCKETS)
+		b = SCHED_HIST_BUCKETS - 1;
+	hist[b]++;
+}
+
+/* Prints the non-empty buckets of HIST. */
+static void
+print_hist (const char *name, const uint64_t hist[]) {
+	printf ("Sched: %s (TSC cycles)\n", name);
+	for (int b = 0; b < SCHED_HIST_BUCKETS; b++)
+		if (hist[b] != 0)
+			printf ("  < 2^%-2d %10"PRIu64"\n", b + 1, hist[b]);
+}
@@ -0,0 +1,318 @@
+#include "threads/slab.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <list.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Object caches.
+
+   malloc() rounds every request up to a power of two and shares
+   one descriptor, and its lock, among all structures of a size
+   class.  A kmem_cache instead hands out objects of one exact
+   size, for one kind of structure, from its own pages, called
+   slabs.
+
+   A slab is one page.  It starts with a struct slab, followed by
+   an array with one index per object that links the free objects
+   together, followed by the objects themselves.  Keeping the
+   links outside the objects means a free object keeps whatever
+   its constructor put in it, so the constructor runs only once,
+   when the slab is made, and not on every allocation.
+
+   Each cache keeps its slabs on three lists, by whether they
+   have free objects, no free objects, or only free objects.
+   Allocation takes from a partly used slab first, so that empty
+   slabs stay empty and can be given back to the page allocator:
+   a cache keeps at most KMEM_EMPTY_MAX of them, and
+   kmem_cache_reclaim() frees them all.
+
+   Caches are never destroyed.  They take a lock, so they may not
+   be used with interrupts off or from an interrupt handler. */
+
+/* Number of empty slabs a cache keeps for later allocations. */
+#define KMEM_EMPTY_MAX 1
+
+/* Marks the end of a slab's free list. */
+#define SLAB_END UINT16_MAX
+
+/* Magic number for detecting slab corruption. */
+#define SLAB_MAGIC 0x51ab51ab
+
+/* An object cache. */
+struct kmem_cache {
+	const char *name;           /* Name, for statistics. */
+	size_t obj_size;            /* Size of an object, padded to alignment. */
+	size_t obj_ofs;             /* Offset of the first object in a slab. */
+	size_t objs_per_slab;       /* Number of objects in a slab. */
+	kmem_ctor_func *ctor;       /* Constructor, or NULL. */
+	struct lock lock;           /* Protects the lists and counts. */
+
+	struct list partial;        /* Slabs with free and used objects. */
+	struct list full;           /* Slabs with no free objects. */
+	struct list empty;          /* Slabs with no used objects. */
+	size_t empty_cnt;           /* Number of slabs in EMPTY. */
+
+	/* Statistics. */
+	size_t slab_cnt;            /* Slabs now held. */
+	size_t active_cnt;          /* Objects now allocated. */
+	uint64_t alloc_cnt;         /* # of kmem_cache_alloc() calls. */
+	uint64_t free_cnt;          /* # of kmem_cache_free() calls. */
+	uint64_t grow_cnt;          /* # of slabs obtained. */
+	uint64_t reclaim_cnt;       /* # of slabs given back. */
+
+	struct kmem_cache *next;    /* Next cache in kmem_cache_print_stats(). */
+};
+
+/* Header at the start of a slab. */
+struct slab {
+	unsigned magic;             /* Always set to SLAB_MAGIC. */
+	struct kmem_cache *cache;   /* Owning cache. */
+	struct list_elem elem;      /* In one of the cache's slab lists. */
+	uint16_t free_cnt;          /* Number of free objects. */
+	uint16_t free_head;         /* First free object, or SLAB_END. */
+	uint16_t next_free[];       /* Next free object after each one. */
+};
+
+/* All caches, in creation order. */
+static struct kmem_cache *caches;
+static struct kmem_cache **caches_tail = &caches;
+
+static struct slab *slab_create (struct kmem_cache *);
+static void slab_destroy (struct kmem_cache *, struct slab *);
+
+/* Returns the address of object IDX in slab S of cache C. */
+static inline void *
+slab_obj (struct kmem_cache *c, struct slab *s, size_t idx) {
+	return (uint8_t *) s + c->obj_ofs + c->obj_size * idx;
+}
+
+/* Creates and returns a cache of SIZE-byte objects aligned to
+   ALIGN bytes, which must be a power of two, or 0 for the
+   natural alignment of a pointer.  If CTOR is nonnull, it is
+   run on every object when its slab is made; freed objects must
+   be returned to that constructed state.  NAME must stay valid
+   for as long as the kernel runs.  Panics if memory is not
+   available, since caches are made during initialization. */
+struct kmem_cache *
+kmem_cache_create (const char *name, size_t size, size_t align,
+		kmem_ctor_func *ctor) {
+	struct kmem_cache *c;
+	enum intr_level old_level;
+	size_t n;
+
+	ASSERT (name != NULL);
+	ASSERT (size > 0);
+	if (align == 0)
+		align = sizeof (void *);
+	ASSERT ((align & (align - 1)) == 0);
+
+	c = malloc (sizeof *c);
+	if (c == NULL)
+		PANIC ("kmem_cache_create: out of memory");
+
+	c->name = name;
+	c->obj_size = ROUND_UP (size, align);
+	c->ctor = ctor;
+
+	/* 헤더, 인덱스 배열, 정렬 패딩을 포함해 한 페이지에 들어가는 최대 개수 */
+	n = (PGSIZE - sizeof (struct slab)) / (c->obj_size + sizeof (uint16_t));
+	while (n > 0 && ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t), align)
+			+ n * c->obj_size > PGSIZE)
+		n--;
+	ASSERT (n > 0 && n < SLAB_END);
+	c->objs_per_slab = n;
+	c->obj_ofs = ROUND_UP (sizeof (struct slab) + n * sizeof (uint16_t), align);
+
+	lock_init (&c->lock);
+	lock_set_name (&c->lock, name);
+	list_init (&c->partial);
+	list_init (&c->full);
+	list_init (&c->empty);
+	c->empty_cnt = 0;
+	c->slab_cnt = c->active_cnt = 0;
+	c->alloc_cnt = c->free_cnt = c->grow_cnt = c->reclaim_cnt = 0;
+
+	c->next = NULL;
+	old_level = intr_disable ();
+	*caches_tail = c;
+	caches_tail = &c->next;
+	intr_set_level (old_level);
+
+	return c;
+}
+
+/* Allocates and returns an object from cache C, or a null pointer
+   if memory is not available. */
+void *
+kmem_cache_alloc (struct kmem_cache *c) {
+	struct slab *s;
+	size_t idx;
+
+	ASSERT (c != NULL);
+
+	lock_acquire (&c->lock);
+	if (list_empty (&c->partial)) {
+		if (!list_empty (&c->empty)) {
+			list_push_front (&c->partial, list_pop_front (&c->empty));
+			c->empty_cnt--;
+		} else {
+			s = slab_create (c);
+			if (s == NULL) {
+				lock_release (&c->lock);
+				return NULL;
+			}
+			list_push_front (&c->partial, &s->elem);
+		}
+	}
+
+	s = list_entry (list_front (&c->partial), struct slab, elem);
+	idx = s->free_head;
+	ASSERT (idx < c->objs_per_slab);
+	s->free_head = s->next_free[idx];
+	if (--s->free_cnt == 0) {
+		list_remove (&s->elem);
+		list_push_front (&c->full, &s->elem);
+	}
+	c->active_cnt++;
+	c->alloc_cnt++;
+	lock_release (&c->lock);
+
+	return slab_obj (c, s, idx);
+}
+
+/* Allocates an object from cache C and fills it with zeros.
+   Returns a null pointer if memory is not available. */
+void *
+kmem_cache_zalloc (struct kmem_cache *c) {
+	void *obj = kmem_cache_alloc (c);
+
+	if (obj != NULL)
+		memset (obj, 0, c->obj_size);
+	return obj;
+}
+
+/* Returns OBJ, which must have been allocated from cache C, to
+   C.  Does nothing if OBJ is a null pointer. */
+void
+kmem_cache_free (struct kmem_cache *c, void *obj) {
+	struct slab *s;
+	size_t idx;
+
+	if (obj == NULL)
+		return;
+
+	s = pg_round_down (obj);
+	ASSERT (s->magic == SLAB_MAGIC);
+	ASSERT (s->cache == c);
+	ASSERT (pg_ofs (obj) >= c->obj_ofs
+			&& (pg_ofs (obj) - c->obj_ofs) % c->obj_size == 0);
+	idx = (pg_ofs (obj) - c->obj_ofs) / c->obj_size;
+
+#ifndef NDEBUG
+	/* Clear the object to help detect use-after-free bugs. */
+	if (c->ctor == NULL)
+		memset (obj, 0xcc, c->obj_size);
+#endif
+
+	lock_acquire (&c->lock);
+	ASSERT (s->free_cnt < c->objs_per_slab);
+	s->next_free[idx] = s->free_head;
+	s->free_head = idx;
+	if (s->free_cnt++ == 0) {
+		list_remove (&s->elem);
+		list_push_front (&c->partial, &s->elem);
+	}
+	if (s->free_cnt == c->objs_per_slab) {
+		list_remove (&s->elem);
+		if (c->empty_cnt < KMEM_EMPTY_MAX) {
+			list_push_front (&c->empty, &s->elem);
+			c->empty_cnt++;
+		} else
+			slab_destroy (c, s);
+	}
+	c->active_cnt--;
+	c->free_cnt++;
+	lock_release (&c->lock);
+}
+
+/* Gives every empty slab of cache C back to the page allocator
+   and returns how many there were. */
+size_t
+kmem_cache_reclaim (struct kmem_cache *c) {
+	size_t cnt = 0;
+
+	ASSERT (c != NULL);
+
+	lock_acquire (&c->lock);
+	while (!list_empty (&c->empty)) {
+		slab_destroy (c, list_entry (list_pop_front (&c->empty),
+					struct slab, elem));
+		cnt++;
+	}
+	c->empty_cnt = 0;
+	lock_release (&c->lock);
+
+	return cnt;
+}
+
+/* Prints the statistics of every cache that has been used. */
+void
+kmem_cache_print_stats (void) {
+	for (struct kmem_cache *c = caches; c != NULL; c = c->next) {
+		if (c->alloc_cnt == 0)
+			continue;
+		printf ("Cache %s: %zu-byte objects, %zu per slab, %zu in use "
+				"in %zu slabs, %"PRIu64" allocs, %"PRIu64" frees, "
+				"%"PRIu64" slabs grown, %"PRIu64" reclaimed\n",
+				c->name, c->obj_size, c->objs_per_slab, c->active_cnt,
+				c->slab_cnt, c->alloc_cnt, c->free_cnt,
+				c->grow_cnt, c->reclaim_cnt);
+	}
+}
+
+/* Obtains a page for a new slab of cache C, with every object
+   free and constructed.  Returns a null pointer if no page is
+   available.  C's lock must be held. */
+static struct slab *
+slab_create (struct kmem_cache *c) {
+	struct slab *s = palloc_get_page (0);
+	size_t i;
+
+	if (s == NULL)
+		return NULL;
+
+	s->magic = SLAB_MAGIC;
+	s->cache = c;
+	s->free_cnt = c->objs_per_slab;
+	s->free_head = 0;
+	for (i = 0; i < c->objs_per_slab; i++) {
+		s->next_free[i] = i + 1 < c->objs_per_slab ? i + 1 : SLAB_END;
+		if (c->ctor != NULL)
+			c->ctor (slab_obj (c, s, i));
+	}
+
+	c->slab_cnt++;
+	c->grow_cnt++;
+	return s;
+}
+
+/* Gives slab S of cache C, which must have no objects in use and
+   be on none of C's lists, back to the page allocator.  C's lock
+   must be held. */
+static void
+slab_destroy (struct kmem_cache *c, struct slab *s) {
+	ASSERT (s->free_cnt == c->objs_per_slab);
+
+	s->magic = 0;
+	palloc_free_page (s);
+	c->slab_cnt--;
+	c->reclaim_cnt++;
+}
@@ -0,0 +1,161 @@
+#include "threads/softirq.h"
+#include <debug.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
+#include "threads/thread.h"
+
+/* Deferred interrupt work ("softirqs").
+
+   An external interrupt handler runs with interrupts off, so
+   every cycle it spends delays every other interrupt.  A handler
+   can instead do the urgent part of its job and call
+   softirq_raise() for the rest.  That sets a bit in the pending
+   mask, and intr_handler() runs the pending softirqs
+   right after acknowledging the interrupt, with interrupts back
+   on and outside interrupt context.
+
+   Softirqs raised while softirqs are already running,
+   for example by a timer tick that interrupts a softirq handler,
+   are picked up by the running loop rather than nesting.  The
+   loop gives up after SOFTIRQ_MAX_RESTART rounds, so that a
+   steady stream of interrupts cannot starve threads; whatever is
+   still pending is then handed to the ksoftirqd kernel thread,
+   which runs at PRI_MAX and is scheduled like any other thread. */
+
+/* Rounds run from an interrupt before deferring to ksoftirqd. */
+#define SOFTIRQ_MAX_RESTART 4
+
+static softirq_func *softirq_handlers[SOFTIRQ_CNT];
+
+/* Only touched with interrupts off. */
+static uint32_t softirq_pending;        /* Bit N: softirq N is raised. */
+static bool in_softirq;                 /* Running softirq handlers? */
+static bool softirq_yield;              /* Yield asked for meanwhile. */
+static struct thread *ksoftirqd_thread; /* Runs softirqs under load. */
+
+static bool do_softirq (void);
+static void ksoftirqd (void *);
+
+/* Starts the ksoftirqd thread.  Must be called after
+   thread_start().  Until then, softirqs only run from interrupt
+   return. */
+void
+softirq_init (void) {
+	thread_create ("ksoftirqd", PRI_MAX, ksoftirqd, NULL);
+}
+
+/* Sets FUNC as the handler for softirq NR. */
+void
+softirq_register (enum softirq_nr nr, softirq_func *func) {
+	ASSERT (nr < SOFTIRQ_CNT);
+	ASSERT (softirq_handlers[nr] == NULL);
+
+	softirq_handlers[nr] = func;
+}
+
+/* Marks softirq NR pending.  It runs when the
+   current interrupt returns.  Normally called from an interrupt
+   handler. */
+void
+softirq_raise (enum softirq_nr nr) {
+	enum intr_level old_level;
+
+	ASSERT (nr < SOFTIRQ_CNT);
+
+	old_level = intr_disable ();
+	softirq_pending |= 1u << nr;
+	intr_set_level (old_level);
+}
+
+/* If softirq handlers are running, arranges
+   for the current thread to yield once they are done, and returns
+   true.  Otherwise returns false, and the caller may yield right
+   away. */
+bool
+softirq_yield_on_return (void) {
+	enum intr_level old_level = intr_disable ();
+	bool running = in_softirq;
+
+	if (running)
+		softirq_yield = true;
+	intr_set_level (old_level);
+	return running;
+}
+
+/* Runs the pending softirqs.  Called by
+   intr_handler() with interrupts off at the end of an external
+   interrupt; YIELD says whether the interrupt handler asked to
+   yield.  Returns true if the caller should call thread_yield().
+   Interrupts are off again on return. */
+bool
+softirq_run (bool yield) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (!intr_context ());
+
+	/* 이미 softirq 실행 중에 들어온 인터럽트: 바깥 루프가 처리 */
+	if (in_softirq) {
+		softirq_yield |= yield;
+		return false;
+	}
+	if (softirq_pending == 0)
+		return yield;
+
+	yield |= do_softirq ();
+
+	/* 너무 오래 돌았으면 나머지는 ksoftirqd에게 */
+	if (softirq_pending != 0 && ksoftirqd_thread != NULL
+			&& ksoftirqd_thread->status == THREAD_BLOCKED) {
+		thread_unblock (ksoftirqd_thread);
+		yield = true;
+	}
+	return yield;
+}
+
+/* Runs the pending softirqs, at most SOFTIRQ_MAX_RESTART rounds.
+   Called with interrupts off, which
+   are turned on while the handlers run.  Returns true if a
+   handler, or an interrupt taken meanwhile, asked to yield. */
+static bool
+do_softirq (void) {
+	bool yield = false;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (!in_softirq);
+
+	in_softirq = true;
+	for (int round = 0; round < SOFTIRQ_MAX_RESTART
+			&& softirq_pending != 0; round++) {
+		uint32_t pending = softirq_pending;
+
+		softirq_pending = 0;
+		intr_enable ();
+		for (int nr = 0; nr < SOFTIRQ_CNT; nr++)
+			if ((pending & (1u << nr)) && softirq_handlers[nr] != NULL
+					&& softirq_handlers[nr] ())
+				yield = true;
+		intr_disable ();
+	}
+	yield |= softirq_yield;
+	softirq_yield = false;
+	in_softirq = false;
+	return yield;
+}
+
+/* Kernel thread that runs softirqs deferred by softirq_run().
+   Blocks while nothing is pending. */
+static void
+ksoftirqd (void *aux UNUSED) {
+	for (;;) {
+		enum intr_level old_level = intr_disable ();
+		bool yield;
+
+		ksoftirqd_thread = thread_current ();
+		if (softirq_pending == 0)
+			thread_block ();
+		yield = do_softirq ();
+		intr_set_level (old_level);
+
+		if (yield)
+			thread_yield ();
+	}
+}
@@ -27,10 +27,34 @@
    */
 
 #include "threads/synch.h"
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/interrupt.h"
+#include "threads/sched-trace.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
+
+static bool waiter_less (const struct heap_elem *a,
+		const struct heap_elem *b, void *aux);
+static void donate_priority (struct thread *holder, struct donation *,
+		int priority);
+static void donate_to_readers (struct rwlock *, int priority);
+static struct lock_stat *stat_alloc (const char *kind, const char *name);
+static void stat_wait (struct lock_stat *, uint64_t start, bool contended);
+static void stat_hold (struct lock_stat *, uint64_t start);
+
+/* Maximum number of named locks.  Locks are named during boot,
+   some of them before malloc() works, so their statistics come
+   from a fixed array instead. */
+#define LOCK_STAT_MAX 64
+
+/* Statistics of named locks, oldest first. */
+static struct lock_stat lock_stats[LOCK_STAT_MAX];
+static size_t lock_stat_cnt;
+
+/* # of locks named after LOCK_STAT_MAX was reached. */
+static size_t lock_stat_dropped;
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -46,9 +70,26 @@ sema_init (struct semaphore *sema, unsigned value) {
 	ASSERT (sema != NULL);
 
 	sema->value = value;
-	list_init (&sema->waiters);
+	heap_init (&sema->waiters, waiter_less, NULL);
 }
 
+/* Orders the waiters of a semaphore by priority.  Among threads
+   of equal priority, the one that started waiting first is
+   greater, so that they are woken up in FIFO order. */
+static bool
+waiter_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	const struct thread *t1 = heap_entry (a, struct thread, wait_elem);
+	const struct thread *t2 = heap_entry (b, struct thread, wait_elem);
+
+	if (t1->priority != t2->priority)
+		return t1->priority < t2->priority;
+	return t1->wait_seq > t2->wait_seq;
+}
+
+/* Next value of thread->wait_seq. */
+static uint64_t wait_seq;
+
 /* Down or "P" operation on a semaphore.  Waits for SEMA's value
    to become positive and then atomically decrements it.
 
@@ -66,12 +107,65 @@ sema_down (struct semaphore *sema) {
 
 	old_level = intr_disable ();
 	while (sema->value == 0) {
-		/* [P1-2] sema→waiters를 우선순위로 정렬 */
-		list_insert_ordered(&sema->waiters, &thread_current ()->elem, compare_priority, NULL);
+		struct thread *curr = thread_current ();
+
+		/* [P1-2] 기다리는 동안 우선순위가 바뀌면 thread_change_priority()가
+		   waiters 힙에서 위치를 고친다 */
+		curr->wait_seq = wait_seq++;
+		curr->waiting_sema = sema;
+		heap_insert (&sema->waiters, &curr->wait_elem);
+		thread_block ();
+	}
+	sema->value--;
+	intr_set_level (old_level);
+}
+
+/* Like sema_down(), but gives up and returns false, without
+   downing SEMA, if the current thread is marked dying, either
+   before it would block or while it waits, in which case the
+   thread that marked it must wake it with sema_kill_wait().
+   Returns true once SEMA is downed.  Use it for waits of
+   unbounded length made on behalf of a user process, so that
+   the process can exit while one of its threads waits. */
+bool
+sema_down_killable (struct semaphore *sema) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (sema != NULL);
+	ASSERT (!intr_context ());
+
+	old_level = intr_disable ();
+	while (sema->value == 0) {
+		if (curr->dying) {
+			intr_set_level (old_level);
+			return false;
+		}
+		curr->wait_seq = wait_seq++;
+		curr->waiting_sema = sema;
+		heap_insert (&sema->waiters, &curr->wait_elem);
+		curr->wait_killable = true;
 		thread_block ();
+		curr->wait_killable = false;
 	}
 	sema->value--;
 	intr_set_level (old_level);
+	return true;
+}
+
+/* If T is blocked in sema_down_killable(), takes it off the
+   semaphore's waiters and wakes it up, so that it sees that it
+   is dying.  Interrupts must be off. */
+void
+sema_kill_wait (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (t->status == THREAD_BLOCKED && t->wait_killable) {
+		heap_remove (&t->waiting_sema->waiters, &t->wait_elem);
+		t->waiting_sema = NULL;
+		t->wait_killable = false;
+		thread_unblock (t);
+	}
 }
 
 /* Down or "P" operation on a semaphore, but only if the
@@ -110,11 +204,12 @@ sema_up (struct semaphore *sema) {
 	ASSERT (sema != NULL);
 
 	old_level = intr_disable ();
-	if (!list_empty (&sema->waiters)){
-		/* [P1-2] Waiter 내의 스레드가 우선순위 기부로 바뀌었을 수 있어 재정렬*/
-		list_sort(&sema->waiters, compare_priority, NULL);
-		thread_unblock (list_entry (list_pop_front (&sema->waiters),
-					struct thread, elem));
+	if (!heap_empty (&sema->waiters)) {
+		struct thread *t = heap_entry (heap_pop_max (&sema->waiters),
+				struct thread, wait_elem);
+
+		t->waiting_sema = NULL;
+		thread_unblock (t);
 	}
 	sema->value++;
 	/* [P1-2] ready_list에 우선 순위가 높은 스레드가 있으면 양보 */
@@ -172,48 +267,197 @@ sema_test_helper (void *sema_) {
    acquire and release it.  When these restrictions prove
    onerous, it's a good sign that a semaphore should be used,
    instead of a lock. */
+void
+lock_init (struct lock *lock) {
+	ASSERT (lock != NULL);
+
+	lock->holder = NULL;
+	sema_init (&lock->semaphore, 1);
+	lock->donation.priority = PRI_MIN - 1;
+	lock->stat = NULL;
+}
+
+/* Names LOCK and starts counting its acquisitions, waits and
+   hold times, which lock_print_stats() prints.  Unnamed locks
+   are not profiled.  LOCK must not be freed afterward, and must
+   not be named twice. */
+void
+lock_set_name (struct lock *lock, const char *name) {
+	ASSERT (lock != NULL);
+	ASSERT (name != NULL);
+	ASSERT (lock->stat == NULL);
+
+	lock->stat = stat_alloc ("Lock", name);
+}
 
-/* [P1-2] 현재 스레드의 lock을 보유한 스레드에게 우선순위 기부*/
+/* Prints the contention statistics of every named lock and
+   readers-writer lock that has been acquired at least once. */
 void
-donate_priority(void){
-    struct thread *curr = thread_current();
-    struct thread *holder;
+lock_print_stats (void) {
+	for (size_t i = 0; i < lock_stat_cnt; i++) {
+		const struct lock_stat *st = &lock_stats[i];
+
+		if (st->acquired == 0)
+			continue;
+		printf ("%s %s: %"PRIu64" acquired, %"PRIu64" contended, "
+				"wait %"PRIu64"/%"PRIu64", hold %"PRIu64"/%"PRIu64
+				" cycles (total/max)\n",
+				st->kind, st->name, st->acquired, st->contended,
+				st->wait_cycles, st->wait_max,
+				st->hold_cycles, st->hold_max);
+	}
+	if (lock_stat_dropped > 0)
+		printf ("Locks: %zu more named locks not profiled\n",
+				lock_stat_dropped);
+}
+
+/* Returns zeroed statistics for the KIND lock NAME, or a null
+   pointer if LOCK_STAT_MAX locks are named already. */
+static struct lock_stat *
+stat_alloc (const char *kind, const char *name) {
+	struct lock_stat *st = NULL;
+	enum intr_level old_level;
+
+	old_level = intr_disable ();
+	if (lock_stat_cnt < LOCK_STAT_MAX) {
+		st = &lock_stats[lock_stat_cnt++];
+		memset (st, 0, sizeof *st);
+		st->kind = kind;
+		st->name = name;
+	} else
+		lock_stat_dropped++;
+	intr_set_level (old_level);
+	return st;
+}
 
-    for(int i = 0; i < 8; i++){
-        if(curr->waiting_lock == NULL) // 락이 없으면 종료
-            return;
-        holder = curr->waiting_lock->holder;
-        holder->priority = curr->priority;
-        curr = holder;
-    }
+/* Counts an acquisition in ST that started waiting at time stamp
+   START, or did not wait at all if CONTENDED is false.  Does
+   nothing if ST is a null pointer.  Interrupts must be off. */
+static void
+stat_wait (struct lock_stat *st, uint64_t start, bool contended) {
+	uint64_t wait;
+
+	if (st == NULL)
+		return;
+	st->acquired++;
+	if (!contended)
+		return;
+	wait = rdtsc () - start;
+	st->contended++;
+	st->wait_cycles += wait;
+	if (wait > st->wait_max)
+		st->wait_max = wait;
 }
 
-/* [P1-2] donation_elem의 priority를 비교하는 새로운 함수*/
+/* Counts in ST a hold that began at time stamp START and ends
+   now.  Does nothing if ST is a null pointer.  Interrupts must
+   be off. */
+static void
+stat_hold (struct lock_stat *st, uint64_t start) {
+	uint64_t hold;
+
+	if (st == NULL)
+		return;
+	hold = rdtsc () - start;
+	st->hold_cycles += hold;
+	if (hold > st->hold_max)
+		st->hold_max = hold;
+}
+
+/* [P1-2] 기부(대기 중인 스레드의 최고 우선순위)를 비교하는 함수 */
 bool
-compare_donation_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED){
-    struct thread *t1 = list_entry(a, struct thread, donation_elem);
-    struct thread *t2 = list_entry(b, struct thread, donation_elem);
-    return t1->priority > t2->priority;
-}
-
-/* [P1-2] lock으로 기부받았던 우선순위를 취소하는 함수 */
-void 
-rollback_priority(void){
-	struct thread *curr = thread_current();
-	if(list_empty(&curr->donations)){
-        curr->priority = curr->init_priority; // donations이 비었으면 초기 priority로 복구
-    } else{
-        struct thread *highest_donor = list_entry(list_front(&curr->donations), struct thread, donation_elem);
-        curr->priority = highest_donor->priority; // 가장 높은 priority를 가진 스레드의 priority 적용
-    }
-};
+lock_priority_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	const struct donation *d1 = heap_entry (a, struct donation, elem);
+	const struct donation *d2 = heap_entry (b, struct donation, elem);
+	return d1->priority < d2->priority;
+}
+
+/* [P1-2] HOLDER가 D를 통해 기다리는 스레드의 우선순위 PRIORITY를 기부받음.
+   HOLDER도 다른 lock을 기다리고 있으면 체인을 끝까지 따라가고, reader들이
+   나가기를 기다리는 writer이면 그 reader들 모두에게 이어서 기부한다.
+   d->priority가 이미 PRIORITY 이상이면 그 뒤는 이미 기부된 상태이므로
+   멈춘다 (교착 상태의 순환도 여기서 끝난다). 인터럽트가 꺼진 상태에서 호출. */
+static void
+donate_priority (struct thread *holder, struct donation *d, int priority) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	while (holder != NULL && d->priority < priority) {
+		struct lock *next;
+
+		d->priority = priority;
+		heap_update (&holder->held_locks, &d->elem);
+		if (holder->priority >= priority)
+			break;
+		thread_change_priority (holder, priority);
+		sched_trace (SCHED_DONATE, holder);
+		if (holder->draining != NULL) {
+			donate_to_readers (holder->draining, priority);
+			break;
+		}
+		next = holder->waiting_lock;
+		if (next == NULL)
+			break;
+		holder = next->holder;
+		d = &next->donation;
+	}
+}
+
+/* Donates PRIORITY to every thread that holds RW for reading,
+   on behalf of a writer waiting for them to leave.  Interrupts
+   must be off. */
+static void
+donate_to_readers (struct rwlock *rw, int priority) {
+	struct list_elem *e;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	for (e = list_begin (&rw->readers); e != list_end (&rw->readers);
+			e = list_next (e)) {
+		struct thread *reader = list_entry (e, struct thread, reader_elem);
+
+		donate_priority (reader, &reader->read_hold, priority);
+	}
+}
 
+/* [P1-2] 현재 스레드의 우선순위를 init_priority와 보유한 lock들이 받은
+   기부 중 가장 높은 값으로 다시 계산 */
 void
-lock_init (struct lock *lock) {
-	ASSERT (lock != NULL);
+refresh_priority (void) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level = intr_disable ();
+	int priority = curr->init_priority;
+
+	if (!heap_empty (&curr->held_locks)) {
+		struct donation *top = heap_entry (heap_max (&curr->held_locks),
+				struct donation, elem);
+		if (top->priority > priority)
+			priority = top->priority;
+	}
+	thread_change_priority (curr, priority);
+	intr_set_level (old_level);
+}
 
-	lock->holder = NULL;
-	sema_init (&lock->semaphore, 1);
+/* Makes the current thread the holder of LOCK, which it has just
+   downed.  The lock inherits the priority of whoever is still
+   waiting on it.  Interrupts must be off. */
+static void
+lock_take (struct lock *lock) {
+	struct thread *curr = thread_current ();
+	struct heap_elem *top = heap_max (&lock->semaphore.waiters);
+
+	lock->holder = curr;
+	if (lock->stat != NULL)
+		lock->stat->acquire_tsc = rdtsc ();
+	if (thread_mlfqs)
+		return;
+
+	lock->donation.priority = top != NULL
+		? heap_entry (top, struct thread, wait_elem)->priority
+		: PRI_MIN - 1;
+	heap_insert (&curr->held_locks, &lock->donation.elem);
+	if (lock->donation.priority > curr->priority)
+		thread_change_priority (curr, lock->donation.priority);
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -224,33 +468,36 @@ lock_init (struct lock *lock) {
    interrupt handler.  This function may be called with
    interrupts disabled, but interrupts will be turned back on if
    we need to sleep. */
-
-/* [P1-2] lock을 보유한 스레드가 현재 스레드보다 우선순위가 낮을 경우, 현재 스레드의 우선순위 기부*/
 void
 lock_acquire (struct lock *lock) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
 	ASSERT (lock != NULL);
 	ASSERT (!intr_context ());
 	ASSERT (!lock_held_by_current_thread (lock));
 
-   /* [P1-3] MLFQS에서 우선순위 기부 비활성화 */
-   if(thread_mlfqs){
-      sema_down(&lock->semaphore);
-      lock->holder = thread_current ();
-      return ;
-   }
-
-	struct thread *curr = thread_current();
-
-	/* [P1-2] 현재 스레드가 기다리는 lock 설정*/
-	curr->waiting_lock = lock;
-
-	if(lock->holder != NULL && lock->holder->priority < curr->priority){
-		list_insert_ordered(&lock->holder->donations, &curr->donation_elem, compare_donation_priority, NULL);
-        donate_priority();
+	old_level = intr_disable ();
+	if (lock->semaphore.value == 0) {
+		/* 이름 붙은 lock만, 기다려야 하는 경우만 대기 시간 측정 */
+		uint64_t start = lock->stat != NULL ? rdtsc () : 0;
+
+		/* [P1-3] MLFQS에서 우선순위 기부 비활성화 */
+		if (!thread_mlfqs) {
+			/* [P1-2] 현재 스레드가 기다리는 lock 설정 후 기부 */
+			curr->waiting_lock = lock;
+			donate_priority (lock->holder, &lock->donation, curr->priority);
+		}
+		sema_down (&lock->semaphore);
+		curr->waiting_lock = NULL;
+		stat_wait (lock->stat, start, true);
 	}
-	sema_down (&lock->semaphore);
-	curr->waiting_lock = NULL;
-	lock->holder = curr;
+	else {
+		sema_down (&lock->semaphore);
+		stat_wait (lock->stat, 0, false);
+	}
+	lock_take (lock);
+	intr_set_level (old_level);
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -261,14 +508,19 @@ lock_acquire (struct lock *lock) {
    interrupt handler. */
 bool
 lock_try_acquire (struct lock *lock) {
+	enum intr_level old_level;
 	bool success;
 
 	ASSERT (lock != NULL);
 	ASSERT (!lock_held_by_current_thread (lock));
 
+	old_level = intr_disable ();
 	success = sema_try_down (&lock->semaphore);
-	if (success)
-		lock->holder = thread_current ();
+	if (success) {
+		stat_wait (lock->stat, 0, false);
+		lock_take (lock);
+	}
+	intr_set_level (old_level);
 	return success;
 }
 
@@ -280,30 +532,24 @@ lock_try_acquire (struct lock *lock) {
    handler. */
 void
 lock_release (struct lock *lock) {
+	enum intr_level old_level;
+
 	ASSERT (lock != NULL);
 	ASSERT (lock_held_by_current_thread (lock));
 
-   /* [P1-3] MLFQS에서 우선순위 기부 비활성화 */
-   if(thread_mlfqs){
-      lock->holder = NULL;
-      sema_up (&lock->semaphore);
-      return ;
-   }
-
-	/* [P1-2] lock을 요청했던 스레드를 donations 목록에서 제거 */
-	struct thread *curr = thread_current();
-    struct list_elem *donor = list_begin(&curr->donations);
-    while(donor != list_end(&curr->donations)){
-        struct thread *t = list_entry(donor, struct thread, donation_elem);
-        if (t->waiting_lock == lock)
-            list_remove(&t->donation_elem);
-        donor = list_next(donor);
-    }
-	/* [P1-2] lock으로 기부받았던 우선순위를 취소 */
-	rollback_priority();
-
+	old_level = intr_disable ();
+	if (lock->stat != NULL)
+		stat_hold (lock->stat, lock->stat->acquire_tsc);
+
+	/* [P1-3] MLFQS에서 우선순위 기부 비활성화 */
+	if (!thread_mlfqs) {
+		/* [P1-2] lock으로 기부받았던 우선순위를 취소 */
+		heap_remove (&thread_current ()->held_locks, &lock->donation.elem);
+		refresh_priority ();
+	}
 	lock->holder = NULL;
 	sema_up (&lock->semaphore);
+	intr_set_level (old_level);
 }
 
 /* Returns true if the current thread holds LOCK, false
@@ -316,20 +562,178 @@ lock_held_by_current_thread (const struct lock *lock) {
 	return lock->holder == thread_current ();
 }
 
+/* Initializes RW as a readers-writer lock held by nobody.  If
+   PREFER_WRITERS is true, a writer that is waiting for readers to
+   leave keeps new readers out, so that writers are not starved;
+   otherwise readers keep coming in until none are left.
+
+   Readers and writers that wait for a writer donate their
+   priority to it through RW's inner lock.  A writer that waits
+   for readers donates its priority to each of them through the
+   reader's read_hold, which stands for the read side held by
+   that thread. */
+void
+rwlock_init (struct rwlock *rw, bool prefer_writers) {
+	ASSERT (rw != NULL);
+
+	lock_init (&rw->lock);
+	list_init (&rw->readers);
+	sema_init (&rw->drained, 0);
+	rw->drain_waiters = 0;
+	rw->prefer_writers = prefer_writers;
+	rw->read_stat = rw->write_stat = NULL;
+}
+
+/* Names RW and starts profiling it like lock_set_name().  Reads
+   and writes are counted apart, each from the moment a thread
+   asks for RW until it has it, and then until it releases it; a
+   writer's wait includes waiting for readers to leave.  RW must
+   not be freed afterward, and must not be named twice. */
+void
+rwlock_set_name (struct rwlock *rw, const char *name) {
+	ASSERT (rw != NULL);
+	ASSERT (name != NULL);
+	ASSERT (rw->read_stat == NULL && rw->write_stat == NULL);
+
+	rw->read_stat = stat_alloc ("RWLock read", name);
+	rw->write_stat = stat_alloc ("RWLock write", name);
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or,
+   with writer preference, waits for it.  The current thread must
+   not hold any readers-writer lock for reading already.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_read_acquire (struct rwlock *rw) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+	uint64_t start = rw->read_stat != NULL ? rdtsc () : 0;
+	bool contended;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (curr->reading == NULL);
+
+	/* writer가 있으면 여기서 기다리며 기부 */
+	contended = !lock_try_acquire (&rw->lock);
+	if (contended)
+		lock_acquire (&rw->lock);
+	old_level = intr_disable ();
+	stat_wait (rw->read_stat, start, contended);
+	if (rw->read_stat != NULL)
+		curr->read_tsc = rdtsc ();
+	curr->reading = rw;
+	list_push_back (&rw->readers, &curr->reader_elem);
+	if (!thread_mlfqs) {
+		curr->read_hold.priority = PRI_MIN - 1;
+		heap_insert (&curr->held_locks, &curr->read_hold.elem);
+	}
+	intr_set_level (old_level);
+	lock_release (&rw->lock);
+}
+
+/* Acquires RW for writing, sleeping until no other thread holds
+   it.  The current thread must not hold RW already.
+
+   This function may sleep, so it must not be called within an
+   interrupt handler. */
+void
+rwlock_write_acquire (struct rwlock *rw) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+	uint64_t start = rw->write_stat != NULL ? rdtsc () : 0;
+	bool contended;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (curr->reading != rw);
+
+	contended = !lock_try_acquire (&rw->lock);
+	if (contended)
+		lock_acquire (&rw->lock);
+	old_level = intr_disable ();
+	contended |= !list_empty (&rw->readers);
+	while (!list_empty (&rw->readers)) {
+		/* 읽는 중인 스레드들에게 기부하고, 기다리는 동안 나에게 오는
+		   기부도 그들에게 넘어가도록 표시 */
+		if (!thread_mlfqs) {
+			curr->draining = rw;
+			donate_to_readers (rw, curr->priority);
+		}
+
+		rw->drain_waiters++;
+		if (!rw->prefer_writers)
+			lock_release (&rw->lock);
+		sema_down (&rw->drained);
+		curr->draining = NULL;
+		if (!rw->prefer_writers)
+			lock_acquire (&rw->lock);
+	}
+	stat_wait (rw->write_stat, start, contended);
+	if (rw->write_stat != NULL)
+		rw->write_stat->acquire_tsc = rdtsc ();
+	intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread must hold for reading or
+   for writing. */
+void
+rwlock_release (struct rwlock *rw) {
+	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (rwlock_held_by_current_thread (rw));
+
+	old_level = intr_disable ();
+	if (lock_held_by_current_thread (&rw->lock)) {
+		if (rw->write_stat != NULL)
+			stat_hold (rw->write_stat, rw->write_stat->acquire_tsc);
+		intr_set_level (old_level);
+		lock_release (&rw->lock);
+		return;
+	}
+
+	stat_hold (rw->read_stat, curr->read_tsc);
+	list_remove (&curr->reader_elem);
+	curr->reading = NULL;
+	if (!thread_mlfqs) {
+		/* 읽는 동안 writer에게 받은 기부를 취소 */
+		heap_remove (&curr->held_locks, &curr->read_hold.elem);
+		refresh_priority ();
+	}
+	if (list_empty (&rw->readers))
+		for (; rw->drain_waiters > 0; rw->drain_waiters--)
+			sema_up (&rw->drained);
+	intr_set_level (old_level);
+}
+
+/* Returns true if the current thread holds RW for reading or for
+   writing, false otherwise. */
+bool
+rwlock_held_by_current_thread (const struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	return thread_current ()->reading == rw
+		|| lock_held_by_current_thread (&rw->lock);
+}
+
 /* One semaphore in a list. */
 struct semaphore_elem {
 	struct list_elem elem;              /* List element. */
 	struct semaphore semaphore;         /* This semaphore. */
+	struct thread *thread;              /* Thread waiting on it. */
 };
 
 /* [P1-2] 세마포어 안의 waiter들의 priority를 비교하는 새로운 함수*/
-bool compare_sema_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED)
-{
-    struct semaphore_elem *s1 = list_entry(a, struct semaphore_elem, elem);
-    struct semaphore_elem *s2 = list_entry(b, struct semaphore_elem, elem);
-    struct thread *root_a = list_entry(list_begin(&(s1->semaphore.waiters)), struct thread, elem);
-    struct thread *root_b = list_entry(list_begin(&(s2->semaphore.waiters)), struct thread, elem);
-    return root_a->priority > root_b->priority;
+static bool
+compare_sema_priority (const struct list_elem *a, const struct list_elem *b,
+		void *aux UNUSED) {
+	struct semaphore_elem *s1 = list_entry (a, struct semaphore_elem, elem);
+	struct semaphore_elem *s2 = list_entry (b, struct semaphore_elem, elem);
+	return s1->thread->priority < s2->thread->priority;
 }
 
 /* Initializes condition variable COND.  A condition variable
@@ -372,7 +776,8 @@ cond_wait (struct condition *cond, struct lock *lock) {
 	ASSERT (lock_held_by_current_thread (lock));
 
 	sema_init (&waiter.semaphore, 0);
-	list_insert_ordered(&cond->waiters, &waiter.elem, compare_sema_priority, NULL);
+	waiter.thread = thread_current ();
+	list_push_back (&cond->waiters, &waiter.elem);
 	lock_release (lock);
 	sema_down (&waiter.semaphore);
 	lock_acquire (lock);
@@ -392,11 +797,13 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED) {
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	if (!list_empty (&cond->waiters)){
-		/* [P1-2] Waiter 내의 스레드가 우선순위 기부로 바뀌었을 수 있어 재정렬*/
-		list_sort(&cond->waiters, compare_sema_priority, NULL);
-		sema_up (&list_entry (list_pop_front (&cond->waiters),
-					struct semaphore_elem, elem)->semaphore);
+	if (!list_empty (&cond->waiters)) {
+		/* [P1-2] 우선순위가 가장 높은 waiter를 깨운다. 같으면 먼저 기다린 쪽 */
+		struct list_elem *e = list_max (&cond->waiters,
+				compare_sema_priority, NULL);
+
+		list_remove (e);
+		sema_up (&list_entry (e, struct semaphore_elem, elem)->semaphore);
 	}
 }
 
@@ -7,9 +7,14 @@
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
+#include "threads/loader.h"
 #include "threads/palloc.h"
+#include "threads/sched-trace.h"
+#include "threads/softirq.h"
+#include "threads/switch.h"
 #include "threads/synch.h"
 #include "threads/vaddr.h"
+#include "devices/timer.h"
 #include "intrinsic.h"
 #include "../include/lib/fixed-point.h"
 #ifdef USERPROG
@@ -28,15 +33,56 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Run queue of processes in THREAD_READY state, that is, processes
+   that are ready to run but not actually running.  There is one
+   FIFO list per priority level, and bit P of ready_mask is set
+   exactly when ready_queues[P] is non-empty, so that the highest
+   ready priority can be found with a single bit scan.  Boosted
+   threads form a prefix of their list, and boost_end[P] points to
+   the first thread after it, so a woken thread is queued behind
+   that prefix in constant time.
+
+   With -cfs, ready threads are kept in cfs_queue instead, ordered
+   by virtual runtime, and ready_queues and ready_mask stay empty.
+
+   Threads in the EDF class (thread_set_deadline()) are kept apart
+   in edf_queue, earliest absolute deadline first, and always run
+   before the others.  An EDF thread that has used up its budget
+   for the period waits on edf_throttled until the next period. */
+#if PRI_MAX >= 64
+#error ready_mask requires PRI_MAX < 64
+#endif
+static struct list ready_queues[PRI_MAX + 1];
+static struct list_elem *boost_end[PRI_MAX + 1]; /* End of boosted prefix. */
+static uint64_t ready_mask;
+static int ready_cnt;           /* # of threads in the run queue. */
+static struct heap cfs_queue;   /* -cfs: smallest vruntime first. */
+static uint64_t min_vruntime;   /* -cfs: monotonic vruntime floor. */
+static unsigned long cfs_load;  /* -cfs: sum of weights in cfs_queue. */
+static struct heap edf_queue;   /* EDF: earliest deadline first. */
+static int edf_cnt;             /* # of threads in edf_queue. */
+static struct list edf_throttled; /* EDF threads out of budget. */
 
 /* [P1-3] 전체 스레드 리스트 */
 static struct list all_list;
 
-/* [P1-1] 휴면 중인 스레드 리스트 */
-static struct list sleep_list;
+/* [P1-1] 휴면 중인 스레드를 깨어날 tick 기준으로 보관하는 계층형 타이밍 휠.
+
+   Level 0 has one bucket per tick of the current 64-tick block, and
+   level 1 has one bucket per 64-tick block for the next 63 blocks.
+   Sleepers further out wait on sleep_overflow.  Entering a new
+   block cascades its level-1 bucket into level 0, and every 4096
+   ticks the overflow list is redistributed, so inserting a sleeper
+   and expiring the due ones are O(1) amortized.  Bit I of
+   sleep_wheel_mask[L] is set exactly when sleep_wheel[L][I] is
+   non-empty. */
+#define WHEEL_BITS 6
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+static struct list sleep_wheel[2][WHEEL_SIZE];
+static uint64_t sleep_wheel_mask[2];
+static struct list sleep_overflow;
+static int64_t sleep_wheel_now;  /* Sleepers due at or before this are awake. */
 
 /* Idle thread. */
 static struct thread *idle_thread;
@@ -44,29 +90,100 @@ static struct thread *idle_thread;
 /* Initial thread, the thread running init.c:main(). */
 static struct thread *initial_thread;
 
-/* Lock used by allocate_tid(). */
+/* Lock used by allocate_tid().  Also protects tid_table. */
 static struct lock tid_lock;
 
+/* Live threads indexed by tid.  Set up in thread_start(), once
+   malloc() is available; a thread leaves it in thread_exit(). */
+static struct hash tid_table;
+
 /* Thread destruction requests */
 static struct list destruction_req;
 
+/* Pages of dead threads, kept for the next thread_create(). */
+#define THREAD_PAGE_CACHE_MAX 16
+static struct list page_cache;
+static int page_cache_cnt;
+
 /* Statistics. */
 static long long idle_ticks;    /* # of timer ticks spent idle. */
-static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
-static long long user_ticks;    /* # of timer ticks in user programs. */
+static long long kernel_ticks;  /* # of timer ticks in kernel mode. */
+static long long user_ticks;    /* # of timer ticks in user mode. */
 
 /* [P1-3] 실행 준비가 된 스레드 수의 이동 평균값 */
 int load_avg;
 
+/* Threads whose recent_cpu is recomputed per interrupts-off
+   section in recalculate_recent_cpu(). */
+#define MLFQS_BATCH 16
+
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
 static unsigned thread_ticks;   /* # of timer ticks since last yield. */
 
+/* Adaptive time slices for the priority scheduler.  A thread's
+   sleep_avg grows by the ticks it spends blocked and shrinks by one
+   for every tick it runs, within [0, SLEEP_AVG_MAX].  Threads that
+   mostly sleep (I/O-bound) get short slices and, when they wake up,
+   are queued ahead of the CPU-bound threads of the same priority.
+   CPU-bound threads get long slices, so they switch less often. */
+#define TIME_SLICE_MIN 2
+#define TIME_SLICE_MAX 12
+#define SLEEP_AVG_MAX TIMER_FREQ
+#define INTERACTIVE_SLEEP_AVG (SLEEP_AVG_MAX / 2)
+#define is_interactive(t) ((t)->sleep_avg >= INTERACTIVE_SLEEP_AVG)
+
+/* Boost for threads woken up from a disk I/O wait, which seldom
+   sleep long enough to earn sleep_avg.  For its next IO_BOOST_TICKS
+   ticks of running, such a thread is queued ahead of, and
+   preempts, the threads of its priority that have no boost, so it
+   can issue its next request while the disk is still warm.  With
+   -cfs, its vruntime is moved back by IO_BOOST_VRUNTIME instead. */
+#define IO_BOOST_TICKS 2
+#define IO_BOOST_VRUNTIME (2 * CFS_WAKEUP_GRANULARITY)
+
 /* If false (default), use round-robin scheduler.
    If true, use multi-level feedback queue scheduler.
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* If true, use the completely fair scheduler.
+   Controlled by kernel command-line option "-cfs". */
+bool thread_cfs;
+
+/* -cfs scheduling.  A running thread's vruntime grows every tick
+   by CFS_TICK_VRUNTIME scaled by CFS_NICE0_WEIGHT over its weight,
+   so CPU time is shared in proportion to weight.  Each thread's
+   time slice is its share of CFS_LATENCY. */
+#define CFS_LATENCY 6           /* Ticks in which all ready threads run. */
+#define CFS_MIN_GRANULARITY 1   /* Shortest time slice, in ticks. */
+#define CFS_TICK_VRUNTIME 10000 /* vruntime of one tick at nice 0 (us). */
+#define CFS_NICE0_WEIGHT 1024
+#define CFS_SLEEPER_CREDIT (CFS_LATENCY * CFS_TICK_VRUNTIME / 2)
+#define CFS_WAKEUP_GRANULARITY CFS_TICK_VRUNTIME
+
+/* EDF class.  Admission control keeps the sum of runtime/deadline
+   over all EDF threads, in units of 1/EDF_BW_UNIT of the CPU,
+   below EDF_BW_MAX, so that normal threads are never starved
+   completely. */
+#define EDF_BW_UNIT (1 << 20)
+#define EDF_BW_MAX (EDF_BW_UNIT / 100 * 95)
+static uint64_t edf_bandwidth;          /* Admitted bandwidth. */
+
+/* Weight of each nice value from -20 to 20.  Each step is about
+   1.25 times the next, so one nice level is about 10% of CPU. */
+static const int cfs_weights[41] = {
+	/* -20 */ 88761, 71755, 56483, 46273, 36291,
+	/* -15 */ 29154, 23254, 18705, 14949, 11916,
+	/* -10 */  9548,  7620,  6100,  4904,  3906,
+	/*  -5 */  3121,  2501,  1991,  1586,  1277,
+	/*   0 */  1024,   820,   655,   526,   423,
+	/*   5 */   335,   272,   215,   172,   137,
+	/*  10 */   110,    87,    70,    56,    45,
+	/*  15 */    36,    29,    23,    18,    15,
+	/*  20 */    12,
+};
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
@@ -75,10 +192,32 @@ static void init_thread (struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule (void);
 static tid_t allocate_tid (void);
+static struct thread *thread_page_get (void);
+static void thread_page_put (struct thread *);
+static hash_hash_func tid_hash;
+static hash_less_func tid_less;
+static void tid_table_insert (struct thread *);
+static void ready_queue_push (struct thread *);
+static void ready_queue_remove (struct thread *);
+static int ready_queue_max_priority (void);
+static heap_less_func cfs_less;
+static int cfs_weight (const struct thread *);
+static void cfs_tick (struct thread *);
+static heap_less_func edf_less;
+static void edf_replenish (struct thread *, int64_t start);
+static void edf_tick (void);
+static int64_t edf_next_replenish (void);
+static int64_t sleep_next_wakeup (void);
+static unsigned thread_time_slice (const struct thread *);
+static void sleep_wheel_insert (struct thread *);
+static bool sleep_wheel_advance (void);
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
 
+/* Returns true if T belongs to the EDF class. */
+#define is_edf_thread(t) ((t)->edf_runtime != 0)
+
 /* Returns the running thread.
  * Read the CPU's stack pointer `rsp', and then round that
  * down to the start of a page.  Since `struct thread' is
@@ -120,13 +259,29 @@ thread_init (void) {
 
 	/* Init the globla thread context */
 	lock_init (&tid_lock);
-	list_init (&ready_list);
+	lock_set_name (&tid_lock, "tid_lock");
+	for (int pri = PRI_MIN; pri <= PRI_MAX; pri++) {
+		list_init (&ready_queues[pri]);
+		boost_end[pri] = list_end (&ready_queues[pri]);
+	}
+	ready_mask = 0;
+	ready_cnt = 0;
+	heap_init (&cfs_queue, cfs_less, NULL);
+	heap_init (&edf_queue, edf_less, NULL);
+	list_init (&edf_throttled);
+	list_init (&page_cache);
 	
 	/* [P1-3] 전체 리스트 초기화 */
 	list_init(&all_list);
 
-	/* [P1-1] 휴면 리스트 초기화 */
-	list_init(&sleep_list);
+	/* [P1-1] 타이밍 휠 초기화 */
+	for (int i = 0; i < WHEEL_SIZE; i++) {
+		list_init (&sleep_wheel[0][i]);
+		list_init (&sleep_wheel[1][i]);
+	}
+	sleep_wheel_mask[0] = sleep_wheel_mask[1] = 0;
+	list_init (&sleep_overflow);
+	sleep_wheel_now = 0;
 
 	list_init (&destruction_req);
 
@@ -144,6 +299,14 @@ thread_init (void) {
    Also creates the idle thread. */
 void
 thread_start (void) {
+	/* Index the initial thread by tid now that malloc() works. */
+	if (!hash_init (&tid_table, tid_hash, tid_less, NULL))
+		PANIC ("thread_start: cannot allocate tid table");
+	tid_table_insert (initial_thread);
+
+	/* Start the clock for -sched-trace latencies. */
+	sched_trace_init ();
+
 	/* Create the idle thread. */
 	struct semaphore idle_started;
 	sema_init (&idle_started, 0);
@@ -156,25 +319,45 @@ thread_start (void) {
 	sema_down (&idle_started);
 }
 
-/* Called by the timer interrupt handler at each timer tick.
-   Thus, this function runs in an external interrupt context. */
+/* Called by the timer interrupt handler at each timer tick, with
+   F the frame of the interrupted code.  Thus, this function runs in
+   an external interrupt context. */
 void
-thread_tick (void) {
+thread_tick (const struct intr_frame *f) {
 	struct thread *t = thread_current ();
 
 	/* Update statistics. */
 	if (t == idle_thread)
 		idle_ticks++;
-#ifdef USERPROG
-	else if (t->pml4 != NULL)
+	/* 시스템 콜 처리 중인 유저 스레드의 tick은 커널 시간 */
+	else if (f->cs == SEL_UCSEG) {
 		user_ticks++;
-#endif
-	else
+		t->usage.user_ticks++;
+	} else {
 		kernel_ticks++;
+		t->usage.kernel_ticks++;
+	}
+
+	/* I/O 완료 가산점은 실행한 tick만큼 소멸 */
+	if (t->io_boost > 0)
+		t->io_boost--;
 
 	/* Enforce preemption. */
-	if (++thread_ticks >= TIME_SLICE)
-		intr_yield_on_return ();
+	if (is_edf_thread (t)) {
+		/* 이번 주기의 예산을 다 쓰면 다음 주기까지 쉼 */
+		if (--t->edf_budget <= 0)
+			intr_yield_on_return ();
+	} else if (thread_cfs && t != idle_thread)
+		cfs_tick (t);
+	else {
+		if (t->sleep_avg > 0)
+			t->sleep_avg--;
+		if (++thread_ticks >= thread_time_slice (t))
+			intr_yield_on_return ();
+	}
+
+	if (!list_empty (&edf_throttled))
+		edf_tick ();
 }
 
 /* Prints thread statistics. */
@@ -207,20 +390,27 @@ thread_create (const char *name, int priority,
 
 	ASSERT (function != NULL);
 
-	/* Allocate thread. */
-	t = palloc_get_page (PAL_ZERO);
+	/* Allocate thread.  init_thread() sets up the struct thread
+	   itself, so the page need not be zeroed. */
+	t = thread_page_get ();
 	if (t == NULL)
 		return TID_ERROR;
 
 	/* Initialize thread. */
 	init_thread (t, name, priority);
 	tid = t->tid = allocate_tid ();
+	tid_table_insert (t);
 
 	/* mlfqs recent_cpu는 부모 값 상속 */
-	if(thread_mlfqs && t != idle_thread){
+	if(thread_mlfqs){
 		t->recent_cpu = thread_current()->recent_cpu;
 		calculate_priority(t);
 	}
+	/* cfs: 부모의 nice와 vruntime을 이어받아 fork로 몫을 늘릴 수 없게 함 */
+	if (thread_cfs) {
+		t->nice = thread_current ()->nice;
+		t->vruntime = thread_current ()->vruntime;
+	}
 	/* Call the kernel_thread if it scheduled.
 	 * Note) rdi is 1st argument, and rsi is 2nd argument. */
 	t->tf.rip = (uintptr_t) kernel_thread;
@@ -257,6 +447,8 @@ void
 thread_block (void) {
 	ASSERT (!intr_context ());
 	ASSERT (intr_get_level () == INTR_OFF);
+	sched_trace (SCHED_BLOCK, thread_current ());
+	thread_current ()->block_tick = timer_ticks ();
 	thread_current ()->status = THREAD_BLOCKED;
 	schedule ();
 }
@@ -278,10 +470,26 @@ thread_unblock (struct thread *t) {
 	old_level = intr_disable ();
 	ASSERT (t->status == THREAD_BLOCKED);
 
-	/* [P1-2] 우선순위로 정렬하여 ready_list에 삽입 */
-	list_insert_ordered(&ready_list, &t->elem, compare_priority, NULL);
+	/* 잠들어 있던 시간만큼 sleep_avg 증가, I/O 위주 스레드는 앞쪽에 삽입 */
+	if (t->block_tick != 0) {
+		int64_t slept = timer_ticks () - t->block_tick;
+		t->sleep_avg = slept >= SLEEP_AVG_MAX - t->sleep_avg
+			? SLEEP_AVG_MAX : t->sleep_avg + (int) slept;
+		t->block_tick = 0;
+	}
+	if (t->io_wait) {
+		t->io_boost = IO_BOOST_TICKS;
+		if (thread_cfs)
+			t->vruntime = t->vruntime > IO_BOOST_VRUNTIME
+				? t->vruntime - IO_BOOST_VRUNTIME : 0;
+	}
+	t->boosted = !thread_mlfqs && (is_interactive (t) || t->io_boost > 0);
+
+	/* [P1-2] 우선순위에 해당하는 준비 큐의 맨 뒤에 삽입 */
+	ready_queue_push (t);
 
 	t->status = THREAD_READY;
+	sched_trace (SCHED_UNBLOCK, t);
 	intr_set_level (old_level);
 }
 
@@ -325,6 +533,14 @@ thread_exit (void) {
 	process_exit ();
 #endif
 
+	lock_acquire (&tid_lock);
+	hash_delete (&tid_table, &thread_current ()->tid_elem);
+	lock_release (&tid_lock);
+
+	/* EDF 대역폭 반환 */
+	if (is_edf_thread (thread_current ()))
+		thread_set_deadline (0, 0, 0);
+
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable ();
@@ -343,8 +559,8 @@ thread_yield (void) {
 
 	old_level = intr_disable ();
 	if (curr != idle_thread)
-		/* [P1-2] 우선순위로 정렬하여 ready_list에 삽입 */
-		list_insert_ordered(&ready_list, &curr->elem, compare_priority, NULL);
+		/* [P1-2] 우선순위에 해당하는 준비 큐의 맨 뒤에 삽입 */
+		ready_queue_push (curr);
 	do_schedule (THREAD_READY);
 	intr_set_level (old_level);
 }
@@ -358,50 +574,148 @@ thread_sleep(int64_t ticks){
     ASSERT(!intr_context());
 
     old_level = intr_disable(); // 인터럽트 비활성화
-    if (curr != idle_thread){
+    /* 이미 지난 시각이면 재우지 않음 */
+    if (curr != idle_thread && ticks > sleep_wheel_now){
         curr->wakeup_tick = ticks;
-        list_insert_ordered(&sleep_list, &curr->elem, compare_wakeup_tick, NULL);
+        sleep_wheel_insert(curr);
+        sched_trace(SCHED_SLEEP, curr);
         thread_block();
     }
     intr_set_level(old_level);   // 인터럽트 활성화
 }
 
-/* [P1-1] 스레드를 깨우기 */
+/* [P1-1] 스레드를 깨우기
+   timer softirq에서 인터럽트가 켜진 채로 호출됨. 밀린 tick이 많아도
+   인터럽트를 끄는 구간은 한 tick씩 */
 bool
 thread_wakeup(int64_t ticks){
+	enum intr_level old_level;
 	bool flag = false;
-	while(!list_empty(&sleep_list)){
-        struct thread *t = list_entry(list_begin(&sleep_list), struct thread, elem);
-        if(t->wakeup_tick > ticks) // 깨울 시간이 될 때까지 스레드 재우기
-            break;
-        list_pop_front(&sleep_list);
-        thread_unblock(t);  // 스레드를 깨움
-		/* [P1-2] ready_list에 우선 순위가 높은 스레드가 있으면 양보 */
-		// thread_preempt();
-		flag = true;
+	bool done = false;
+	while(!done){
+		old_level = intr_disable();
+		if(sleep_wheel_now < ticks && sleep_wheel_advance())
+			flag = true;
+		done = sleep_wheel_now >= ticks;
+		intr_set_level(old_level);
 	}
 	return flag;
 }
 
-/* [P1-1] 스레드의 wakeup_tick을 비교하는 새로운 함수*/
-bool
-compare_wakeup_tick(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED){
-    struct thread *t1 = list_entry(a, struct thread, elem);
-    struct thread *t2 = list_entry(b, struct thread, elem);
-    return t1->wakeup_tick < t2->wakeup_tick;
+/* Returns the earliest tick at which the scheduler needs a timer
+   interrupt: a sleeping thread may need to be woken,
+   or a throttled EDF thread gets its budget back.  Returns
+   INT64_MAX if there is neither.  The result may be early, but
+   never late.  Must be called with interrupts off. */
+int64_t
+thread_next_wakeup (void) {
+	int64_t sleep = sleep_next_wakeup ();
+	int64_t edf = edf_next_replenish ();
+
+	return sleep < edf ? sleep : edf;
 }
 
-/* [P1-2] 스레드의 priority를 비교하는 새로운 함수*/
-bool
-compare_priority(const struct list_elem *a, const struct list_elem *b, void *aux UNUSED){
-    struct thread *t1 = list_entry(a, struct thread, elem);
-    struct thread *t2 = list_entry(b, struct thread, elem);
+/* Returns the earliest tick at which a sleeping thread may need
+   to be woken, or INT64_MAX if no thread is asleep.  The result
+   may be earlier than the actual wakeup_tick of any sleeper, but
+   never later.  Must be called with interrupts off. */
+static int64_t
+sleep_next_wakeup (void) {
+	int64_t now = sleep_wheel_now;
+	int64_t next_block = (now >> WHEEL_BITS) + 1;
+	int shift = next_block & WHEEL_MASK;
+	uint64_t pending;
 
-	if(aux == NULL)
-    	return t1->priority > t2->priority;
+	ASSERT (intr_get_level () == INTR_OFF);
 
-	else
-		return t1->priority < t2->priority;
+	/* 현재 블록에서 아직 지나지 않은 tick */
+	pending = sleep_wheel_mask[0] & ~((2ULL << (now & WHEEL_MASK)) - 1);
+	if (pending != 0)
+		return (now & ~(int64_t) WHEEL_MASK) + __builtin_ctzll (pending);
+
+	/* 이후 블록은 블록이 시작될 때 cascade 되므로 그 시점을 반환 */
+	pending = sleep_wheel_mask[1];
+	if (shift != 0)
+		pending = (pending >> shift) | (pending << (WHEEL_SIZE - shift));
+	if (pending != 0)
+		return (next_block + __builtin_ctzll (pending)) << WHEEL_BITS;
+
+	/* overflow 리스트는 4096 tick마다 재분배됨 */
+	if (!list_empty (&sleep_overflow))
+		return ((now >> (2 * WHEEL_BITS)) + 1) << (2 * WHEEL_BITS);
+	return INT64_MAX;
+}
+
+/* Puts sleeping thread T into the timing wheel bucket that covers
+   its wakeup_tick.  T->wakeup_tick must be in the future relative
+   to sleep_wheel_now, or equal to it while a block is cascading. */
+static void
+sleep_wheel_insert (struct thread *t) {
+	int64_t now_block = sleep_wheel_now >> WHEEL_BITS;
+	int64_t block = t->wakeup_tick >> WHEEL_BITS;
+	int level, idx;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (t->wakeup_tick >= sleep_wheel_now);
+
+	if (block == now_block) {
+		level = 0;
+		idx = t->wakeup_tick & WHEEL_MASK;
+	} else if (block - now_block < WHEEL_SIZE) {
+		level = 1;
+		idx = block & WHEEL_MASK;
+	} else {
+		list_push_back (&sleep_overflow, &t->elem);
+		return;
+	}
+	list_push_back (&sleep_wheel[level][idx], &t->elem);
+	sleep_wheel_mask[level] |= 1ULL << idx;
+}
+
+/* Moves every sleeper in BUCKET back through sleep_wheel_insert(),
+   which places it relative to the new sleep_wheel_now. */
+static void
+sleep_wheel_cascade (struct list *bucket) {
+	struct list pending;
+
+	list_init (&pending);
+	while (!list_empty (bucket))
+		list_push_back (&pending, list_pop_front (bucket));
+	while (!list_empty (&pending))
+		sleep_wheel_insert (list_entry (list_pop_front (&pending),
+					struct thread, elem));
+}
+
+/* Advances the timing wheel by one tick and wakes every thread
+   due at the new time.  Returns true if any thread was woken. */
+static bool
+sleep_wheel_advance (void) {
+	int64_t now = ++sleep_wheel_now;
+	int idx = now & WHEEL_MASK;
+	struct list *bucket;
+	bool flag = false;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (idx == 0) {
+		int block_idx = (now >> WHEEL_BITS) & WHEEL_MASK;
+
+		if (block_idx == 0)
+			sleep_wheel_cascade (&sleep_overflow);
+		sleep_wheel_mask[1] &= ~(1ULL << block_idx);
+		sleep_wheel_cascade (&sleep_wheel[1][block_idx]);
+	}
+
+	bucket = &sleep_wheel[0][idx];
+	while (!list_empty (bucket)) {
+		struct thread *t = list_entry (list_pop_front (bucket), struct thread, elem);
+		ASSERT (t->wakeup_tick == now);
+		sched_trace (SCHED_WAKEUP, t);
+		thread_unblock (t);  // 스레드를 깨움
+		flag = true;
+	}
+	sleep_wheel_mask[0] &= ~(1ULL << idx);
+	return flag;
 }
 
 /* [P1-2] ready_list에 우선 순위가 높은 스레드가 있으면 양보하는 새로운 함수 */
@@ -410,37 +724,100 @@ thread_preempt(void){
 	/* [P1-3] MLFQS에서는 선점 X */
 	// if(thread_mlfqs)
 	// 	return;
-	if(thread_current() == idle_thread)
+	struct thread *curr = thread_current();
+	bool yield;
+	if(curr == idle_thread)
 		return;
-	if(list_empty(&ready_list))
+	if(ready_cnt == 0)
 		return;
-	if(thread_current()->priority < thread_get_highest_priority()->priority)
-		thread_yield();
+	if (edf_cnt != 0) {
+		/* EDF 스레드는 일반 스레드보다 항상 먼저, EDF끼리는 마감이 이른 쪽 */
+		struct thread *next = thread_get_highest_priority ();
+		yield = !is_edf_thread (curr) || next->edf_abs_deadline < curr->edf_abs_deadline;
+	}
+	else if (is_edf_thread (curr))
+		return;
+	else if (thread_cfs) {
+		/* cfs: 깨어난 스레드가 충분히 덜 실행되었을 때만 양보 */
+		struct thread *next = thread_get_highest_priority ();
+		yield = next->vruntime + CFS_WAKEUP_GRANULARITY < curr->vruntime;
+	}
+	else {
+		int max = ready_queue_max_priority ();
+
+		/* 같은 우선순위라도 I/O 완료로 깨어난 스레드는 가산점이 없는 스레드를 선점 */
+		yield = curr->priority < max;
+		if (curr->priority == max && curr->io_boost == 0 && !thread_mlfqs) {
+			struct thread *next = thread_get_highest_priority ();
+			yield = next->boosted && next->io_boost > 0;
+		}
+	}
+	if (!yield)
+		return;
+
+	/* 인터럽트나 softirq 처리 중이면 끝난 뒤에 양보 */
+	if (intr_context ())
+		intr_yield_on_return ();
+	else if (!softirq_yield_on_return ())
+		thread_yield ();
+}
+
+/* Marks the blocking waits of the running thread, until
+   thread_io_end(), as waits for disk I/O, so that it gets a
+   temporary boost each time it is woken up from one. */
+void
+thread_io_begin (void) {
+	thread_current ()->io_wait = true;
+}
+
+/* Ends the section started by thread_io_begin(). */
+void
+thread_io_end (void) {
+	thread_current ()->io_wait = false;
+}
+
+/* Changes T's priority to PRIORITY.  If T is in the run queue, it
+   is moved to the tail of the queue for its new priority, so
+   priority donation to a ready thread takes effect immediately.
+   If T is waiting on a semaphore, its place among the waiters is
+   updated as well. */
+void
+thread_change_priority (struct thread *t, int priority) {
+	enum intr_level old_level;
+
+	ASSERT (is_thread (t));
+	ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
+
+	old_level = intr_disable ();
+	if (t->priority != priority) {
+		if (t->status == THREAD_READY && !thread_cfs && !is_edf_thread (t)) {
+			ready_queue_remove (t);
+			t->priority = priority;
+			ready_queue_push (t);
+		} else {
+			t->priority = priority;
+			if (t->waiting_sema != NULL)
+				heap_update (&t->waiting_sema->waiters, &t->wait_elem);
+		}
+	}
+	intr_set_level (old_level);
 }
 
 /* Sets the current thread's priority to NEW_PRIORITY. */
 void
 thread_set_priority (int new_priority) {
 	thread_current ()->init_priority = new_priority;
-	/* [P1-2] lock으로 기부받았던 우선순위 되돌리기 */
-	rollback_priority();
+	/* [P1-2] lock으로 기부받은 우선순위를 고려해 다시 계산 */
+	refresh_priority();
 	/* [P1-2] ready_list에 우선 순위가 높은 스레드가 있으면 양보 */
 	thread_preempt();
 }
 
-/* [P1-2] 우선순위 기부를 고려하여 현재 스레드의 우선순위를 반환하는 함수 */
+/* Returns the current thread's priority.  In the presence of
+   priority donation, returns the higher (donated) priority. */
 int
 thread_get_priority (void) {
-	struct thread *t = thread_current();
-	int max_priority = t->priority;
-	struct list_elem *e;
-    for(e = list_begin(&t->donations); e != list_end(&t->donations); e = list_next(e)){
-        struct thread *donor = list_entry(e, struct thread, donation_elem);
-        if (donor->priority > max_priority) {
-            max_priority = donor->priority;
-        }
-    }
-	return max_priority;
+	return thread_current ()->priority;
 }
 
 /* [P1-3] 스레드의 우선순위를 계산하는 새로운 함수 */
@@ -451,7 +828,7 @@ calculate_priority(struct thread *t){
 	int p = fp_to_int_round(fp_sub_fp(int_to_fp(PRI_MAX - t->nice * 2), int_div_fp(t->recent_cpu, 4)));
 	if(p > PRI_MAX) p = PRI_MAX;
 	else if(p < PRI_MIN) p = PRI_MIN;
-	t->priority = p;
+	thread_change_priority(t, p);
 }
 
 /* [P1-3] 현재 스레드의 nice 값을 새 값으로 설정 */
@@ -501,26 +878,46 @@ add_recent_cpu(void){
     	t->recent_cpu = int_add_fp(t->recent_cpu, 1);
 }
 
-/* [P1-3] 모든 스레드의 priority 값 계산 */
+/* [P1-3] 실행 중인 스레드의 priority 값 계산
+   recent_cpu는 매 tick 실행 중인 스레드만 증가하므로, 초 단위 갱신
+   사이에는 다른 스레드의 priority가 바뀌지 않음 */
 void
 recalculate_priority(void){
-  struct list_elem *e;
-  for(e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)){
-    struct thread *t = list_entry(e, struct thread, allelem);
-    calculate_priority(t);
-  }
+	calculate_priority(thread_current());
 }
 
-/* [P1-3] 모든 스레드의 recent_cpu 값 계산 */
+/* [P1-3] 모든 스레드의 recent_cpu와 priority 값 계산
+   매 초 한 번만 all_list 전체를 순회하며, priority가 바뀐 스레드만
+   준비 큐 사이를 이동함. 인터럽트를 끄는 구간이 스레드 수에 비례하지
+   않도록 MLFQS_BATCH개씩 처리하고, 사이사이 cursor를 all_list에
+   꽂아 위치를 기억함 */
 void
 recalculate_recent_cpu(void){
+  static struct list_elem cursor;
   struct list_elem *e;
-  for(e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)){
-    struct thread *t = list_entry(e, struct thread, allelem);
-	if(t == idle_thread)
-    	return;
-	t->recent_cpu = int_add_fp(fp_mul_fp(fp_div_fp(int_mul_fp(load_avg, 2), int_add_fp(int_mul_fp(load_avg, 2), 1)), t->recent_cpu), t->nice);
+  enum intr_level old_level;
+  int decay = fp_div_fp(int_mul_fp(load_avg, 2), int_add_fp(int_mul_fp(load_avg, 2), 1));
+
+  old_level = intr_disable();
+  e = list_begin(&all_list);
+  for(;;){
+    for(int i = 0; i < MLFQS_BATCH && e != list_end(&all_list); i++, e = list_next(e)){
+      struct thread *t = list_entry(e, struct thread, allelem);
+      if(t == idle_thread)
+        continue;
+      t->recent_cpu = int_add_fp(fp_mul_fp(decay, t->recent_cpu), t->nice);
+      calculate_priority(t);
+    }
+    if(e == list_end(&all_list))
+      break;
+    /* 다음 스레드 앞에 cursor를 두고 잠시 인터럽트 허용 */
+    list_insert(e, &cursor);
+    intr_set_level(old_level);
+    old_level = intr_disable();
+    e = list_next(&cursor);
+    list_remove(&cursor);
   }
+  intr_set_level(old_level);
 }
 
 /* [P1-3] 시스템의 load_avg 값 계산 */
@@ -529,9 +926,9 @@ recalculate_load_avg(void){
 	int ready_threads;
 	//enum intr_level old_level = intr_disable ();
 	if(thread_current () == idle_thread)
-		ready_threads = list_size(&ready_list);
+		ready_threads = ready_cnt;
 	else
-		ready_threads = list_size(&ready_list) + 1; // 현재 실행 중인 스레드도 포함
+		ready_threads = ready_cnt + 1; // 현재 실행 중인 스레드도 포함
   	load_avg = fp_add_fp(fp_mul_fp(fp_div_fp(int_to_fp(59), int_to_fp(60)), load_avg), int_mul_fp(fp_div_fp(int_to_fp(1), int_to_fp(60)), ready_threads));
 	//intr_set_level(old_level);
 }
@@ -548,9 +945,13 @@ recalculate_load_avg(void){
 static void
 idle (void *idle_started_ UNUSED) {
 	struct semaphore *idle_started = idle_started_;
+	enum intr_level old_level;
 
 	idle_thread = thread_current ();
+	/* recalculate_recent_cpu()가 all_list를 순회하는 도중일 수 있음 */
+	old_level = intr_disable ();
 	list_remove(&idle_thread->allelem);
+	intr_set_level (old_level);
 	sema_up (idle_started);
 
 	for (;;) {
@@ -558,6 +959,9 @@ idle (void *idle_started_ UNUSED) {
 		intr_disable ();
 		thread_block ();
 
+		/* Tickless 모드에서는 다음 deadline까지 주기적 tick을 멈춤 */
+		timer_idle_enter ();
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -586,35 +990,68 @@ kernel_thread (thread_func *function, void *aux) {
 
 
 /* Does basic initialization of T as a blocked thread named
-   NAME. */
+   NAME.  T may be a recycled page still holding a dead thread, so
+   every member that is read before it is written gets a value
+   here; list elems, parent_if and the like are left alone. */
 static void
 init_thread (struct thread *t, const char *name, int priority) {
 	ASSERT (t != NULL);
 	ASSERT (PRI_MIN <= priority && priority <= PRI_MAX);
 	ASSERT (name != NULL);
 
-	memset (t, 0, sizeof *t);
 	t->status = THREAD_BLOCKED;
 	strlcpy (t->name, name, sizeof t->name);
+	memset (&t->tf, 0, sizeof t->tf);
 	t->tf.rsp = (uint64_t) t + PGSIZE - sizeof (void *);
+	t->switch_rsp = 0;
 	t->priority = priority;
 	t->magic = THREAD_MAGIC;
 
+	/* 스케줄러와 동기화 관련 값 */
+	t->ready_tsc = 0;
+	t->ready_woken = false;
+	t->wakeup_tick = 0;
+	t->waiting_sema = NULL;
+	t->wait_seq = 0;
+	t->wait_killable = false;
+	t->reading = NULL;
+	t->read_tsc = 0;
+	t->sleep_avg = 0;
+	t->block_tick = 0;
+	t->boosted = false;
+	t->io_wait = false;
+	t->io_boost = 0;
+	t->vruntime = 0;
+	t->cfs_weight = 0;
+	t->edf_runtime = 0;
+	t->edf_deadline = 0;
+	t->edf_period = 0;
+	t->edf_period_start = 0;
+	t->edf_abs_deadline = 0;
+	t->edf_budget = 0;
+	t->edf_throttled = false;
+	memset (&t->usage, 0, sizeof t->usage);
+	memset (&t->child_usage, 0, sizeof t->child_usage);
+
 	/* [P1-2] 스레드의 초기 우선순위 저장 */
 	t->init_priority = priority;
 	
 	/* [P1-2] 다른 스레드 점유가 해제되기를 기다리고 있는 lock 초기화 */
 	t->waiting_lock = NULL;
 
-	/* [P1-2] 스레드의 기부자 목록 초기화 */
-	list_init(&(t->donations));	
+	/* [P1-2] 스레드가 보유한 lock 힙 초기화 */
+	heap_init (&t->held_locks, lock_priority_less, NULL);
+	t->read_hold.priority = PRI_MIN - 1;
+	t->draining = NULL;
 
 	/* [P1-3] MLFQS 변수 초기화 */
 	t->nice = 0;
   	t->recent_cpu = 0;
 
 	/* [P1-3] 전체 리스트에 스레드 추가 */
+	enum intr_level old_level = intr_disable ();
 	list_push_back(&all_list, &t->allelem);
+	intr_set_level (old_level);
 
 	/* P2 자식 리스트 초기화, process용 semaphore 초기화, 기타 변수 초기화 */
 	list_init(&t->child_list);
@@ -622,38 +1059,315 @@ init_thread (struct thread *t, const char *name, int priority) {
 	sema_init(&t->exit_sema, 0);
 	lock_init(&t->fork_lock);
 	sema_init(&t->process_init_sema, 0);
+	t->leader = t;
+	t->thread_cnt = 1;
+	list_init(&t->threads);
+	sema_init(&t->threads_done, 0);
+	t->dying = false;
+	memset (t->fds, 0, sizeof t->fds);
+	lock_init(&t->fd_lock);
 	t->exit_status = -1;
+	t->has_been_waited = false;
+	t->parent = NULL;
+	t->is_dup_success = false;
 	t->is_kernel = false;
 
 	/* (P2) 기본적으로 kernel thread로 취급, user_thread는 process.c에서 변경 */
 	t->is_kernel = true;
 	t->running_file = NULL;
 
+#ifdef USERPROG
+	t->pml4 = NULL;
+#endif
+#ifdef VM
+	/* 커널 스레드도 process_exit에서 빈 SPT로 정리됨 */
+	memset (&t->spt, 0, sizeof t->spt);
+	t->user_rsp = 0;
+#endif
 #ifdef EFILESYS
 	t->pwd = NULL;
 #endif
 }
 
-struct thread* thread_get_highest_priority(){
-	if (list_empty (&ready_list))
+/* Appends T to the run queue for its priority, or with -cfs
+   inserts it by vruntime.  Must be called with interrupts off. */
+static void
+ready_queue_push (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (is_edf_thread (t)) {
+		int64_t now = timer_ticks ();
+
+		/* 마감이 지났거나, 남은 예산을 마감까지 쓰면 허가받은 대역폭을
+		   넘는 경우 지금부터 새 주기를 시작 */
+		if (now >= t->edf_abs_deadline
+				|| t->edf_budget * t->edf_deadline
+				> (t->edf_abs_deadline - now) * t->edf_runtime)
+			edf_replenish (t, now);
+		if (t->edf_budget <= 0) {
+			t->edf_throttled = true;
+			list_push_back (&edf_throttled, &t->elem);
+			return;
+		}
+		heap_insert (&edf_queue, &t->edf_elem);
+		edf_cnt++;
+	} else if (thread_cfs) {
+		/* 오래 잠들었던 스레드도 min_vruntime보다 반 주기 이상 앞서지 않게 */
+		uint64_t floor = min_vruntime > CFS_SLEEPER_CREDIT
+			? min_vruntime - CFS_SLEEPER_CREDIT : 0;
+		if (t->vruntime < floor)
+			t->vruntime = floor;
+		t->cfs_weight = cfs_weight (t);
+		cfs_load += t->cfs_weight;
+		heap_insert (&cfs_queue, &t->cfs_elem);
+	} else {
+		struct list *q = &ready_queues[t->priority];
+		struct list_elem **end = &boost_end[t->priority];
+
+		/* 깨어난 I/O 위주 스레드는 같은 우선순위의 다른 boosted 스레드 뒤,
+		   CPU 위주 스레드 앞에 넣음 */
+		if (t->boosted)
+			list_insert (*end, &t->elem);
+		else {
+			list_push_back (q, &t->elem);
+			if (*end == list_end (q))
+				*end = &t->elem;
+		}
+		ready_mask |= 1ULL << t->priority;
+	}
+	ready_cnt++;
+}
+
+/* Removes T from the run queue.
+   Must be called with interrupts off. */
+static void
+ready_queue_remove (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (is_edf_thread (t)) {
+		if (t->edf_throttled) {
+			t->edf_throttled = false;
+			list_remove (&t->elem);
+			return;
+		}
+		heap_remove (&edf_queue, &t->edf_elem);
+		edf_cnt--;
+	} else if (thread_cfs) {
+		heap_remove (&cfs_queue, &t->cfs_elem);
+		cfs_load -= t->cfs_weight;
+	} else {
+		if (boost_end[t->priority] == &t->elem)
+			boost_end[t->priority] = list_next (&t->elem);
+		list_remove (&t->elem);
+		if (list_empty (&ready_queues[t->priority]))
+			ready_mask &= ~(1ULL << t->priority);
+	}
+	ready_cnt--;
+}
+
+/* Returns the highest priority among ready threads.
+   The run queue must not be empty. */
+static int
+ready_queue_max_priority (void) {
+	ASSERT (ready_mask != 0);
+
+	return 63 - __builtin_clzll (ready_mask);
+}
+
+/* Returns the number of ticks T may run before being preempted
+   in favor of another thread of the same priority. */
+static unsigned
+thread_time_slice (const struct thread *t) {
+	if (thread_mlfqs || t == idle_thread)
+		return TIME_SLICE;
+	return TIME_SLICE_MAX
+		- (TIME_SLICE_MAX - TIME_SLICE_MIN) * t->sleep_avg / SLEEP_AVG_MAX;
+}
+
+/* Orders cfs_queue so that its maximum is the thread with the
+   smallest vruntime. */
+static bool
+cfs_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	const struct thread *t1 = heap_entry (a, struct thread, cfs_elem);
+	const struct thread *t2 = heap_entry (b, struct thread, cfs_elem);
+
+	return t1->vruntime > t2->vruntime;
+}
+
+/* Returns T's -cfs weight, derived from its nice value. */
+static int
+cfs_weight (const struct thread *t) {
+	int nice = t->nice;
+
+	if (nice < -20)
+		nice = -20;
+	else if (nice > 20)
+		nice = 20;
+	return cfs_weights[nice + 20];
+}
+
+/* Charges running thread T for one timer tick and ends its time
+   slice once it has run for its share of CFS_LATENCY.
+   Called from the timer interrupt. */
+static void
+cfs_tick (struct thread *t) {
+	int weight = cfs_weight (t);
+	uint64_t vmin;
+	unsigned slice;
+
+	t->vruntime += (uint64_t) CFS_TICK_VRUNTIME * CFS_NICE0_WEIGHT / weight;
+
+	slice = CFS_LATENCY * weight / (cfs_load + weight);
+	vmin = t->vruntime;
+	if (!heap_empty (&cfs_queue)) {
+		struct thread *first = heap_entry (heap_max (&cfs_queue),
+				struct thread, cfs_elem);
+		if (first->vruntime < vmin)
+			vmin = first->vruntime;
+	}
+	if (vmin > min_vruntime)
+		min_vruntime = vmin;
+
+	if (slice < CFS_MIN_GRANULARITY)
+		slice = CFS_MIN_GRANULARITY;
+	if (++thread_ticks >= slice)
+		intr_yield_on_return ();
+}
+
+/* Orders edf_queue so that its maximum is the thread with the
+   earliest absolute deadline. */
+static bool
+edf_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	const struct thread *t1 = heap_entry (a, struct thread, edf_elem);
+	const struct thread *t2 = heap_entry (b, struct thread, edf_elem);
+
+	return t1->edf_abs_deadline > t2->edf_abs_deadline;
+}
+
+/* Starts a new period of EDF thread T at tick START, with a full
+   budget. */
+static void
+edf_replenish (struct thread *t, int64_t start) {
+	t->edf_period_start = start;
+	t->edf_abs_deadline = start + t->edf_deadline;
+	t->edf_budget = t->edf_runtime;
+}
+
+/* Moves the throttled EDF threads whose next period has begun
+   back to edf_queue.  Called from the timer interrupt. */
+static void
+edf_tick (void) {
+	int64_t now = timer_ticks ();
+	bool woken = false;
+	struct list_elem *e;
+
+	for (e = list_begin (&edf_throttled); e != list_end (&edf_throttled);) {
+		struct thread *t = list_entry (e, struct thread, elem);
+
+		e = list_next (e);
+		if (t->edf_period_start + t->edf_period <= now) {
+			list_remove (&t->elem);
+			t->edf_throttled = false;
+			edf_replenish (t, t->edf_period_start + t->edf_period);
+			heap_insert (&edf_queue, &t->edf_elem);
+			edf_cnt++;
+			ready_cnt++;
+			woken = true;
+		}
+	}
+
+	if (woken)
+		intr_yield_on_return ();
+}
+
+/* Returns the tick at which the first throttled EDF thread starts
+   its next period, or INT64_MAX if none is throttled.  Must be
+   called with interrupts off. */
+static int64_t
+edf_next_replenish (void) {
+	int64_t next = INT64_MAX;
+	struct list_elem *e;
+
+	for (e = list_begin (&edf_throttled); e != list_end (&edf_throttled);
+			e = list_next (e)) {
+		struct thread *t = list_entry (e, struct thread, elem);
+
+		if (t->edf_period_start + t->edf_period < next)
+			next = t->edf_period_start + t->edf_period;
+	}
+	return next;
+}
+
+/* Moves the current thread into the EDF class: every PERIOD ticks
+   it may run for RUNTIME ticks, which must be completed within
+   DEADLINE ticks of the start of the period, with RUNTIME <=
+   DEADLINE <= PERIOD.  EDF threads run before all other threads,
+   earliest deadline first, and are stopped until their next period
+   once they use up RUNTIME.  Returns false, leaving the thread
+   unchanged, if admitting it would exceed the EDF bandwidth limit.
+   A RUNTIME of 0 moves the thread back to the normal class. */
+bool
+thread_set_deadline (int64_t runtime, int64_t deadline, int64_t period) {
+	struct thread *curr = thread_current ();
+	uint64_t old_bw = 0, new_bw = 0;
+	enum intr_level old_level;
+	bool success = false;
+
+	if (runtime < 0 || (runtime > 0 && (runtime > deadline || deadline > period)))
+		return false;
+	if (is_edf_thread (curr))
+		old_bw = curr->edf_runtime * EDF_BW_UNIT / curr->edf_deadline;
+	if (runtime > 0)
+		new_bw = runtime * EDF_BW_UNIT / deadline;
+
+	old_level = intr_disable ();
+	if (edf_bandwidth - old_bw + new_bw <= EDF_BW_MAX) {
+		edf_bandwidth = edf_bandwidth - old_bw + new_bw;
+		success = true;
+	}
+
+	if (success) {
+		curr->edf_runtime = runtime;
+		curr->edf_deadline = deadline;
+		curr->edf_period = period;
+		if (runtime > 0)
+			edf_replenish (curr, timer_ticks ());
+		thread_preempt ();
+	}
+	intr_set_level (old_level);
+	return success;
+}
+
+/* Returns the thread that would be run next, without removing it
+   from the run queue, or the idle thread if the run queue is
+   empty. */
+struct thread* thread_get_highest_priority(void){
+	if (ready_cnt == 0)
 		return idle_thread;
+	else if (edf_cnt != 0)
+		return heap_entry (heap_max (&edf_queue), struct thread, edf_elem);
+	else if (thread_cfs)
+		return heap_entry (heap_max (&cfs_queue), struct thread, cfs_elem);
 	else {
-		return list_entry (list_max(&ready_list, compare_priority, 1), struct thread, elem);
+		return list_entry (list_front (&ready_queues[ready_queue_max_priority ()]),
+				struct thread, elem);
 	}
 }
 
 /* Chooses and returns the next thread to be scheduled.  Should
    return a thread from the run queue, unless the run queue is
    empty.  (If the running thread can continue running, then it
-   will be in the run queue.)  If the run queue is empty, return
-   idle_thread. */
+   will be in the run queue.)  If the run queue is empty, returns
+   the idle thread. */
 static struct thread *
 next_thread_to_run (void) {
-	if (list_empty (&ready_list))
+	if (ready_cnt == 0)
 		return idle_thread;
 	else{
 		struct thread* t = thread_get_highest_priority();
-		list_remove(&t->elem);
+		ready_queue_remove(t);
 		return t;
 	}
 }
@@ -698,61 +1412,17 @@ do_iret (struct intr_frame *tf) {
    added at the end of the function. */
 static void
 thread_launch (struct thread *th) {
-	uint64_t tf_cur = (uint64_t) &running_thread ()->tf;
-	uint64_t tf = (uint64_t) &th->tf;
+	struct thread *curr = running_thread ();
 	ASSERT (intr_get_level () == INTR_OFF);
 
-	/* The main switching logic.
-	 * We first restore the whole execution context into the intr_frame
-	 * and then switching to the next thread by calling do_iret.
-	 * Note that, we SHOULD NOT use any stack from here
-	 * until switching is done. */
-	__asm __volatile (
-			/* Store registers that will be used. */
-			"push %%rax\n"
-			"push %%rbx\n"
-			"push %%rcx\n"
-			/* Fetch input once */
-			"movq %0, %%rax\n"
-			"movq %1, %%rcx\n"
-			"movq %%r15, 0(%%rax)\n"
-			"movq %%r14, 8(%%rax)\n"
-			"movq %%r13, 16(%%rax)\n"
-			"movq %%r12, 24(%%rax)\n"
-			"movq %%r11, 32(%%rax)\n"
-			"movq %%r10, 40(%%rax)\n"
-			"movq %%r9, 48(%%rax)\n"
-			"movq %%r8, 56(%%rax)\n"
-			"movq %%rsi, 64(%%rax)\n"
-			"movq %%rdi, 72(%%rax)\n"
-			"movq %%rbp, 80(%%rax)\n"
-			"movq %%rdx, 88(%%rax)\n"
-			"pop %%rbx\n"              // Saved rcx
-			"movq %%rbx, 96(%%rax)\n"
-			"pop %%rbx\n"              // Saved rbx
-			"movq %%rbx, 104(%%rax)\n"
-			"pop %%rbx\n"              // Saved rax
-			"movq %%rbx, 112(%%rax)\n"
-			"addq $120, %%rax\n"
-			"movw %%es, (%%rax)\n"
-			"movw %%ds, 8(%%rax)\n"
-			"addq $32, %%rax\n"
-			"call __next\n"         // read the current rip.
-			"__next:\n"
-			"pop %%rbx\n"
-			"addq $(out_iret -  __next), %%rbx\n"
-			"movq %%rbx, 0(%%rax)\n" // rip
-			"movw %%cs, 8(%%rax)\n"  // cs
-			"pushfq\n"
-			"popq %%rbx\n"
-			"mov %%rbx, 16(%%rax)\n" // eflags
-			"mov %%rsp, 24(%%rax)\n" // rsp
-			"movw %%ss, 32(%%rax)\n"
-			"mov %%rcx, %%rdi\n"
-			"call do_iret\n"
-			"out_iret:\n"
-			: : "g"(tf_cur), "g" (tf) : "memory"
-			);
+	/* Every switch happens inside schedule(), so both threads are in
+	 * kernel mode and only the callee-saved registers and the stack
+	 * pointer have to be swapped.  A thread that has never run has no
+	 * saved stack yet and is started from its intr_frame instead. */
+	if (th->switch_rsp != 0)
+		switch_to (&curr->switch_rsp, th->switch_rsp);
+	else
+		switch_to_iret (&curr->switch_rsp, &th->tf);
 }
 
 /* Schedules a new process. At entry, interrupts must be off.
@@ -768,7 +1438,7 @@ do_schedule(int status) {
 			list_entry (list_pop_front (&destruction_req), struct thread, elem);
 		/* thread 종료 시 all list에서 제거 */
 		list_remove(&victim->allelem);
-		palloc_free_page(victim);
+		thread_page_put(victim);
 	}
 	thread_current ()->status = status;
 	schedule ();
@@ -784,16 +1454,30 @@ schedule (void) {
 	ASSERT (is_thread (next));
 	/* Mark us as running. */
 	next->status = THREAD_RUNNING;
+	next->boosted = false;
 
 	/* Start new time slice. */
 	thread_ticks = 0;
 
+	/* Idle에서 벗어나면 주기적 tick을 다시 켬 */
+	if (curr == idle_thread && next != idle_thread)
+		timer_idle_exit ();
+
 #ifdef USERPROG
 	/* Activate the new address space. */
 	process_activate (next);
 #endif
 
 	if (curr != next) {
+		/* 스스로 block했으면 자발적, 선점/양보로 밀려났으면 비자발적 전환 */
+		if (curr->status == THREAD_BLOCKED)
+			curr->usage.voluntary_switches++;
+		else if (curr->status == THREAD_READY)
+			curr->usage.involuntary_switches++;
+
+		sched_trace (SCHED_SWITCH_OUT, curr);
+		sched_trace (SCHED_SWITCH_IN, next);
+
 		/* If the thread we switched from is dying, destroy its struct
 		   thread. This must happen late so that thread_exit() doesn't
 		   pull out the rug under itself.
@@ -812,6 +1496,39 @@ schedule (void) {
 	}
 }
 
+/* Returns a page for a new thread, reusing one of a recently
+   destroyed thread if any is cached.  Returns NULL if no page is
+   available. */
+static struct thread *
+thread_page_get (void) {
+	struct thread *t = NULL;
+	enum intr_level old_level = intr_disable ();
+
+	if (!list_empty (&page_cache)) {
+		t = list_entry (list_pop_front (&page_cache), struct thread, elem);
+		page_cache_cnt--;
+	}
+	intr_set_level (old_level);
+
+	return t != NULL ? t : palloc_get_page (0);
+}
+
+/* Releases the page of dead thread VICTIM, keeping it in the
+   cache unless the cache is full.
+   Must be called with interrupts off. */
+static void
+thread_page_put (struct thread *victim) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (page_cache_cnt < THREAD_PAGE_CACHE_MAX) {
+		/* 남은 포인터로 죽은 스레드를 쓰지 못하게 magic 제거 */
+		victim->magic = 0;
+		list_push_front (&page_cache, &victim->elem);
+		page_cache_cnt++;
+	} else
+		palloc_free_page (victim);
+}
+
 /* Returns a tid to use for a new thread. */
 static tid_t
 allocate_tid (void) {
@@ -825,14 +1542,40 @@ allocate_tid (void) {
 	return tid;
 }
 
+/* Returns the live thread whose tid is TID, or NULL if there is
+   no such thread (it never existed or has already exited). */
 struct thread* thread_get_by_tid(tid_t tid){
-	if(list_empty(&all_list)) return NULL;
+	/* struct thread는 커널 스택에 두기에 크므로 lock으로 보호되는 정적 key 사용 */
+	static struct thread key;
+	struct hash_elem *e;
 
-	struct thread* t;
-	for(struct list_elem* walk = list_begin(&all_list); walk != list_end(&all_list); walk = list_next(walk)){
-		t = list_entry(walk, struct thread, allelem);
-		if(t->tid == tid) return t;
-	}
+	lock_acquire (&tid_lock);
+	key.tid = tid;
+	e = hash_find (&tid_table, &key.tid_elem);
+	lock_release (&tid_lock);
+	return e != NULL ? hash_entry (e, struct thread, tid_elem) : NULL;
+}
+
+/* Adds T to tid_table. */
+static void
+tid_table_insert (struct thread *t) {
+	lock_acquire (&tid_lock);
+	hash_insert (&tid_table, &t->tid_elem);
+	lock_release (&tid_lock);
+}
+
+/* Hash function for tid_table. */
+static uint64_t
+tid_hash (const struct hash_elem *e, void *aux UNUSED) {
+	return hash_int (hash_entry (e, struct thread, tid_elem)->tid);
+}
+
+/* Orders tid_table elements by tid. */
+static bool
+tid_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct thread, tid_elem)->tid
+		< hash_entry (b, struct thread, tid_elem)->tid;
 }
 
 /*
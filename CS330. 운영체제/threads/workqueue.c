@@ -0,0 +1,466 @@
+#include "threads/workqueue.h"
+#include <debug.h>
+#include <stddef.h>
+#include "threads/interrupt.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "devices/timer.h"
+
+/* Workqueues.
+
+   A workqueue is a FIFO list of struct work plus a pool of kernel
+   threads that take works off the list and run them.  Code that
+   must not wait, such as a system call that wants to write a page
+   back or a page fault that wants to read ahead, queues a work
+   instead, and one of the workers runs it in thread context,
+   where it may sleep, take locks and do disk I/O.
+
+   A work is either idle, queued on one workqueue, or delayed:
+   waiting in delayed_works for its tick to come, after which
+   workqueue_timer() moves it onto its queue.  Queueing a work
+   that is already pending does nothing, so a subsystem may queue
+   the same work from many places and have it run once.  A work
+   is no longer pending by the time its function runs, so the
+   function may queue it again, or free it.
+
+   All lists and the members of struct work are only touched with
+   interrupts off, so works may be queued and cancelled from
+   interrupt handlers.  Each workqueue's
+   work_sema counts the works queued on it; a worker that finds
+   the list empty anyway, because a work was cancelled, simply
+   waits again. */
+
+/* Number of workers in system_wq. */
+#define SYSTEM_WQ_WORKERS 2
+
+/* One worker thread. */
+struct worker {
+	struct workqueue *wq;       /* Queue it serves. */
+	struct work *current;       /* Work being run, or NULL. */
+};
+
+/* A workqueue. */
+struct workqueue {
+	const char *name;           /* Name of the worker threads. */
+	struct list works;          /* Queued works, oldest first. */
+	struct semaphore work_sema; /* Upped once per queued work. */
+	struct list flushers;       /* Threads in flush_*(). */
+	struct worker *workers;     /* Worker threads. */
+	int worker_cnt;             /* # of elements in workers. */
+	int busy_cnt;               /* # of workers running a work. */
+	bool dying;                 /* Set by workqueue_destroy(). */
+	struct semaphore exited;    /* Upped by each exiting worker. */
+};
+
+/* A thread waiting in flush_work() or flush_workqueue(). */
+struct flusher {
+	struct list_elem elem;      /* In workqueue's flushers. */
+	struct work *work;          /* Work to wait for, or NULL for all. */
+	struct semaphore done;      /* Upped when the wait is over. */
+};
+
+struct workqueue *system_wq;
+
+/* Delayed works of every workqueue, earliest due at the top. */
+static struct heap delayed_works;
+
+static void worker_loop (void *);
+static bool due_later (const struct heap_elem *, const struct heap_elem *,
+		void *);
+static bool flush_done (struct workqueue *, struct flusher *);
+static void collect_flushers (struct workqueue *, struct list *);
+static void wake_flushers (struct list *);
+static void wait_flush (struct workqueue *, struct work *);
+
+/* Creates system_wq.  Must be called after thread_start(). */
+void
+workqueue_init (void) {
+	heap_init (&delayed_works, due_later, NULL);
+	system_wq = workqueue_create ("kworker", SYSTEM_WQ_WORKERS,
+			PRI_DEFAULT);
+	if (system_wq == NULL)
+		PANIC ("workqueue_init: cannot create system_wq");
+}
+
+/* Creates a workqueue served by WORKER_CNT kernel threads named
+   NAME, running at PRIORITY.  Returns the new workqueue, or a null
+   pointer if memory or threads could not be allocated. */
+struct workqueue *
+workqueue_create (const char *name, int worker_cnt, int priority) {
+	struct workqueue *wq;
+
+	ASSERT (name != NULL);
+	ASSERT (worker_cnt > 0);
+
+	wq = malloc (sizeof *wq);
+	if (wq == NULL)
+		return NULL;
+	wq->workers = calloc (worker_cnt, sizeof *wq->workers);
+	if (wq->workers == NULL) {
+		free (wq);
+		return NULL;
+	}
+	wq->name = name;
+	list_init (&wq->works);
+	sema_init (&wq->work_sema, 0);
+	list_init (&wq->flushers);
+	wq->worker_cnt = 0;
+	wq->busy_cnt = 0;
+	wq->dying = false;
+	sema_init (&wq->exited, 0);
+
+	for (int i = 0; i < worker_cnt; i++) {
+		struct worker *w = &wq->workers[i];
+
+		w->wq = wq;
+		w->current = NULL;
+		if (thread_create (name, priority, worker_loop, w) == TID_ERROR) {
+			workqueue_destroy (wq);
+			return NULL;
+		}
+		wq->worker_cnt++;
+	}
+	return wq;
+}
+
+/* Runs every work queued on WQ, stops its workers and frees it.
+   No work may be delayed on WQ, and no more may be queued. */
+void
+workqueue_destroy (struct workqueue *wq) {
+	enum intr_level old_level;
+
+	flush_workqueue (wq);
+
+	old_level = intr_disable ();
+	wq->dying = true;
+	intr_set_level (old_level);
+
+	for (int i = 0; i < wq->worker_cnt; i++)
+		sema_up (&wq->work_sema);
+	for (int i = 0; i < wq->worker_cnt; i++)
+		sema_down (&wq->exited);
+	free (wq->workers);
+	free (wq);
+}
+
+/* Initializes WORK to call FUNC with AUX when it runs. */
+void
+work_init (struct work *work, work_func *func, void *aux) {
+	ASSERT (work != NULL);
+	ASSERT (func != NULL);
+
+	work->func = func;
+	work->aux = aux;
+	work->wq = NULL;
+	work->due = 0;
+	work->pending = false;
+}
+
+/* Queues WORK on WQ, to be run by one of its workers.  Returns
+   false, doing nothing, if WORK is already pending.  May be called
+   from an interrupt handler. */
+bool
+queue_work (struct workqueue *wq, struct work *work) {
+	enum intr_level old_level;
+	bool queued = false;
+
+	ASSERT (wq != NULL);
+	ASSERT (work != NULL && work->func != NULL);
+
+	old_level = intr_disable ();
+	if (!work->pending) {
+		ASSERT (!wq->dying);
+		work->pending = true;
+		work->wq = wq;
+		work->due = 0;
+		list_push_back (&wq->works, &work->elem);
+		queued = true;
+	}
+
+	if (queued)
+		sema_up (&wq->work_sema);
+	intr_set_level (old_level);
+	return queued;
+}
+
+/* Queues WORK on WQ once TICKS timer ticks have passed.  Returns
+   false, doing nothing, if WORK is already pending.  May be called
+   from an interrupt handler. */
+bool
+queue_delayed_work (struct workqueue *wq, struct work *work, int64_t ticks) {
+	enum intr_level old_level;
+	bool queued = false;
+
+	ASSERT (wq != NULL);
+	ASSERT (work != NULL && work->func != NULL);
+
+	if (ticks <= 0)
+		return queue_work (wq, work);
+
+	old_level = intr_disable ();
+	if (!work->pending) {
+		work->pending = true;
+		work->wq = wq;
+		work->due = timer_ticks () + ticks;
+		heap_insert (&delayed_works, &work->delay_elem);
+		queued = true;
+	}
+	intr_set_level (old_level);
+	return queued;
+}
+
+/* Removes WORK from its queue or from the delayed list, if it is
+   pending, and returns true.  Returns false if WORK was not
+   pending.  WORK may still be running when this returns; see
+   cancel_work_sync(). */
+bool
+cancel_work (struct work *work) {
+	enum intr_level old_level;
+	struct list woken;
+	bool was_pending;
+
+	ASSERT (work != NULL);
+
+	list_init (&woken);
+	old_level = intr_disable ();
+	was_pending = work->pending;
+	if (was_pending) {
+		if (work->due != 0)
+			heap_remove (&delayed_works, &work->delay_elem);
+		else
+			list_remove (&work->elem);
+		work->pending = false;
+		work->due = 0;
+		/* 큐가 비었을 수 있으니 flush 대기자 확인 */
+		collect_flushers (work->wq, &woken);
+	}
+	wake_flushers (&woken);
+	intr_set_level (old_level);
+	return was_pending;
+}
+
+/* Like cancel_work(), but also waits until WORK is not running
+   anymore.  Must not be called from WORK itself. */
+bool
+cancel_work_sync (struct work *work) {
+	bool was_pending = cancel_work (work);
+
+	flush_work (work);
+	return was_pending;
+}
+
+/* Waits until WORK is neither pending nor running.  A delayed
+   WORK is queued right away rather than waited for. */
+void
+flush_work (struct work *work) {
+	ASSERT (work != NULL);
+	ASSERT (!intr_context ());
+
+	if (work->wq != NULL)
+		wait_flush (work->wq, work);
+}
+
+/* Waits until WQ has no queued works and none of its workers is
+   running one.  Works queued meanwhile are waited for too.
+   Delayed works are not.  Must not be called from a work on WQ. */
+void
+flush_workqueue (struct workqueue *wq) {
+	ASSERT (wq != NULL);
+	ASSERT (!intr_context ());
+
+	wait_flush (wq, NULL);
+}
+
+/* Queues WORK on system_wq. */
+bool
+schedule_work (struct work *work) {
+	return queue_work (system_wq, work);
+}
+
+/* Queues WORK on system_wq once TICKS timer ticks have passed. */
+bool
+schedule_delayed_work (struct work *work, int64_t ticks) {
+	return queue_delayed_work (system_wq, work, ticks);
+}
+
+/* Returns the tick at which the first delayed work is due, or
+   INT64_MAX if no work is delayed.  Must be called with interrupts
+   off. */
+int64_t
+workqueue_next_due (void) {
+	int64_t due = INT64_MAX;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (system_wq == NULL)
+		return due;
+	if (!heap_empty (&delayed_works))
+		due = heap_entry (heap_max (&delayed_works), struct work, delay_elem)->due;
+	return due;
+}
+
+/* Moves the delayed works that are due at NOW onto their queues.
+   Called from the timer softirq.  Does nothing until
+   workqueue_init() has run. */
+void
+workqueue_timer (int64_t now) {
+	if (system_wq == NULL)
+		return;
+
+	/* 인터럽트를 끄는 구간은 work 하나씩 */
+	for (;;) {
+		enum intr_level old_level = intr_disable ();
+		struct workqueue *wq = NULL;
+
+		if (!heap_empty (&delayed_works)) {
+			struct work *work = heap_entry (heap_max (&delayed_works),
+					struct work, delay_elem);
+
+			if (work->due <= now) {
+				heap_pop_max (&delayed_works);
+				work->due = 0;
+				wq = work->wq;
+				list_push_back (&wq->works, &work->elem);
+			}
+		}
+		if (wq != NULL)
+			sema_up (&wq->work_sema);
+		intr_set_level (old_level);
+
+		if (wq == NULL)
+			break;
+	}
+}
+
+/* Worker thread.  Runs the works queued on W's workqueue, one at
+   a time, until the workqueue is destroyed. */
+static void
+worker_loop (void *w_) {
+	struct worker *w = w_;
+	struct workqueue *wq = w->wq;
+
+	for (;;) {
+		enum intr_level old_level;
+		struct list woken;
+		struct work *work = NULL;
+		work_func *func = NULL;
+		void *aux = NULL;
+
+		sema_down (&wq->work_sema);
+
+		old_level = intr_disable ();
+		if (wq->dying) {
+			intr_set_level (old_level);
+			break;
+		}
+		if (!list_empty (&wq->works)) {
+			work = list_entry (list_pop_front (&wq->works), struct work, elem);
+			work->pending = false;
+			func = work->func;
+			aux = work->aux;
+			w->current = work;
+			wq->busy_cnt++;
+		}
+		intr_set_level (old_level);
+
+		/* 취소된 work의 몫으로 깨어난 경우 */
+		if (work == NULL)
+			continue;
+
+		func (aux);
+
+		list_init (&woken);
+		old_level = intr_disable ();
+		w->current = NULL;
+		wq->busy_cnt--;
+		collect_flushers (wq, &woken);
+		wake_flushers (&woken);
+		intr_set_level (old_level);
+	}
+	sema_up (&wq->exited);
+}
+
+/* Orders works by due tick, so that the work due first is the
+   maximum of delayed_works. */
+static bool
+due_later (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED) {
+	const struct work *a = heap_entry (a_, struct work, delay_elem);
+	const struct work *b = heap_entry (b_, struct work, delay_elem);
+
+	return a->due > b->due;
+}
+
+/* Returns true if the wait of flusher F on WQ is over.  Must be
+   called with interrupts off. */
+static bool
+flush_done (struct workqueue *wq, struct flusher *f) {
+	if (f->work == NULL)
+		return list_empty (&wq->works) && wq->busy_cnt == 0;
+	if (f->work->pending)
+		return false;
+	for (int i = 0; i < wq->worker_cnt; i++)
+		if (wq->workers[i].current == f->work)
+			return false;
+	return true;
+}
+
+/* Moves the flushers of WQ whose wait is over to WOKEN.  Must be
+   called with interrupts off. */
+static void
+collect_flushers (struct workqueue *wq, struct list *woken) {
+	struct list_elem *e = list_begin (&wq->flushers);
+
+	while (e != list_end (&wq->flushers)) {
+		struct flusher *f = list_entry (e, struct flusher, elem);
+
+		e = list_next (e);
+		if (flush_done (wq, f)) {
+			list_remove (&f->elem);
+			list_push_back (woken, &f->elem);
+		}
+	}
+}
+
+/* Wakes the flushers in WOKEN, once they are off the flushers
+   list. */
+static void
+wake_flushers (struct list *woken) {
+	while (!list_empty (woken)) {
+		struct flusher *f = list_entry (list_pop_front (woken),
+				struct flusher, elem);
+
+		sema_up (&f->done);
+	}
+}
+
+/* Waits until WORK on WQ, or all of WQ if WORK is null, is done. */
+static void
+wait_flush (struct workqueue *wq, struct work *work) {
+	enum intr_level old_level;
+	struct flusher f;
+	bool queued = false;
+	bool done;
+
+	f.work = work;
+	sema_init (&f.done, 0);
+
+	old_level = intr_disable ();
+	/* 지연된 work는 기다리지 않고 바로 큐에 넣음 */
+	if (work != NULL && work->pending && work->due != 0) {
+		heap_remove (&delayed_works, &work->delay_elem);
+		work->due = 0;
+		list_push_back (&wq->works, &work->elem);
+		queued = true;
+	}
+	done = flush_done (wq, &f);
+	if (!done)
+		list_push_back (&wq->flushers, &f.elem);
+	if (queued)
+		sema_up (&wq->work_sema);
+	intr_set_level (old_level);
+
+	if (!done)
+		sema_down (&f.done);
+}
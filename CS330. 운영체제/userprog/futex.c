@@ -0,0 +1,195 @@
+#include "userprog/futex.h"
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <stdint.h>
+#include "threads/interrupt.h"
+#include "threads/mmu.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "vm/vm.h"
+
+/* Futexes ("fast user-space mutexes").
+
+   A user program keeps the state of a lock or condition variable
+   in an ordinary int and changes it with atomic instructions.
+   Only when it has to sleep, or has to wake someone up, does it
+   call futex_wait() or futex_wake(), so an uncontended lock never
+   enters the kernel.
+
+   The kernel keeps no state for a futex except the threads that
+   sleep on it.  Sleepers are kept in a hash table of wait queues,
+   keyed by the address space and user address of the int.  File
+   mappings are keyed the same way: each process that maps a file
+   gets its own copy of the pages, so the same file offset in two
+   processes is two different ints, and must not share a queue.
+
+   futex_wait() compares the int with the value the caller saw
+   and goes to sleep with interrupts off, so a futex_wake() from a
+   thread that changed the int in between cannot be missed.
+
+   When a process exits while some of its threads sleep on
+   futexes, futex_wake_space() wakes them all so that they can
+   see that they are dying, and a dying thread never goes to
+   sleep on a futex again. */
+
+/* Number of wait queues.  Must be a power of 2. */
+#define FUTEX_BUCKETS 64
+
+/* Where a futex's int is stored. */
+struct futex_key {
+	const void *space;          /* Page table of the address space. */
+	uint64_t offset;            /* User address. */
+};
+
+/* A thread sleeping in futex_wait(). */
+struct futex_waiter {
+	struct list_elem elem;      /* Element in a futex bucket. */
+	struct futex_key key;       /* Futex being waited on. */
+	struct thread *thread;      /* Sleeping thread. */
+};
+
+static struct list futex_buckets[FUTEX_BUCKETS];
+
+static int *pin_user_int (int *uaddr, enum intr_level *);
+static void get_key (const int *uaddr, struct futex_key *);
+static struct list *key_bucket (const struct futex_key *);
+
+/* Initializes the futex wait queues. */
+void
+futex_init (void) {
+	for (int i = 0; i < FUTEX_BUCKETS; i++)
+		list_init (&futex_buckets[i]);
+}
+
+/* If the int at user address UADDR still holds VAL, sleeps until
+   futex_wake() is called on it and returns 0.  Otherwise returns
+   -1 right away.  Returns -1 as well if UADDR is not a valid,
+   aligned user address. */
+int
+futex_wait (int *uaddr, int val) {
+	struct futex_waiter w;
+	enum intr_level old_level;
+	int *kaddr;
+
+	if (!is_user_vaddr (uaddr) || (uintptr_t) uaddr % sizeof (int) != 0)
+		return -1;
+	kaddr = pin_user_int (uaddr, &old_level);
+	if (kaddr == NULL)
+		return -1;
+	get_key (uaddr, &w.key);
+
+	if (*kaddr != val) {
+		intr_set_level (old_level);
+		return -1;
+	}
+	w.thread = thread_current ();
+	/* futex_wake_space() 이후에 들어온 경우 잠들면 안 됨 */
+	if (w.thread->dying) {
+		intr_set_level (old_level);
+		return -1;
+	}
+	list_push_back (key_bucket (&w.key), &w.elem);
+	thread_block ();
+	intr_set_level (old_level);
+	return 0;
+}
+
+/* Wakes up to CNT threads sleeping in futex_wait() on the int at
+   user address UADDR, oldest first, and returns how many were
+   woken.  Returns -1 if UADDR is not a mapped user address. */
+int
+futex_wake (int *uaddr, int cnt) {
+	struct futex_key key;
+	enum intr_level old_level;
+	struct list *bucket;
+	struct list_elem *e;
+	int woken = 0;
+
+	if (!is_user_vaddr (uaddr))
+		return -1;
+	if (pin_user_int (uaddr, &old_level) == NULL)
+		return -1;
+	get_key (uaddr, &key);
+	bucket = key_bucket (&key);
+	for (e = list_begin (bucket); e != list_end (bucket) && woken < cnt; ) {
+		struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+
+		e = list_next (e);
+		if (w->key.space == key.space && w->key.offset == key.offset) {
+			list_remove (&w->elem);
+			thread_unblock (w->thread);
+			woken++;
+		}
+	}
+	intr_set_level (old_level);
+
+	/* 깨운 스레드의 우선순위가 더 높으면 양보 */
+	if (woken > 0)
+		thread_preempt ();
+	return woken;
+}
+
+/* Wakes every thread sleeping in futex_wait() on any futex in
+   the address space whose page table is PML4.  Called by an
+   exiting process, after marking its threads dying. */
+void
+futex_wake_space (const void *pml4) {
+	enum intr_level old_level = intr_disable ();
+
+	for (int i = 0; i < FUTEX_BUCKETS; i++) {
+		struct list *bucket = &futex_buckets[i];
+		struct list_elem *e;
+
+		for (e = list_begin (bucket); e != list_end (bucket); ) {
+			struct futex_waiter *w = list_entry (e, struct futex_waiter, elem);
+
+			e = list_next (e);
+			if (w->key.space == pml4) {
+				list_remove (&w->elem);
+				thread_unblock (w->thread);
+			}
+		}
+	}
+	intr_set_level (old_level);
+}
+
+/* Brings the page holding user address UADDR into memory and
+   returns the kernel address of the int at UADDR, with interrupts
+   turned off so that the page cannot be evicted.  The previous
+   interrupt level is stored in *OLD_LEVEL.  Returns a null pointer,
+   with interrupts as they were, if UADDR is not mapped. */
+static int *
+pin_user_int (int *uaddr, enum intr_level *old_level) {
+	struct thread *curr = thread_current ();
+
+	for (;;) {
+		int *kaddr;
+
+		*old_level = intr_disable ();
+		kaddr = pml4_get_page (curr->pml4, uaddr);
+		if (kaddr != NULL)
+			return kaddr;
+		intr_set_level (*old_level);
+
+		/* 아직 올라오지 않았거나 쫓겨난 페이지 */
+		if (!vm_claim_page (uaddr))
+			return NULL;
+	}
+}
+
+/* Stores in *KEY the key of the futex at user address UADDR in
+   the current process.  Threads made by clone() share the page
+   table, so they share keys as well. */
+static void
+get_key (const int *uaddr, struct futex_key *key) {
+	key->space = thread_current ()->pml4;
+	key->offset = (uint64_t) uaddr;
+}
+
+/* Returns the wait queue for KEY. */
+static struct list *
+key_bucket (const struct futex_key *key) {
+	return &futex_buckets[hash_bytes (key, sizeof *key) & (FUTEX_BUCKETS - 1)];
+}
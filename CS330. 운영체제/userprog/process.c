@@ -7,6 +7,7 @@
 #include <string.h>
 #include "userprog/gdt.h"
 #include "userprog/tss.h"
+#include "userprog/futex.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/filesys.h"
@@ -30,6 +31,12 @@ static void process_cleanup (void);
 static bool load (const char *file_name, struct intr_frame *if_);
 static void initd (void *f_name);
 static void __do_fork (void *);
+static void start_clone (void *);
+static void exit_clone (struct thread *);
+static void release_clones (struct thread *);
+static void kill_clones (struct thread *);
+static void release_children (struct thread *);
+static void rusage_add (struct rusage *, const struct rusage *);
 
 void
 parse_filename(void *f_name, char **file_name, char** args);
@@ -37,16 +44,39 @@ parse_filename(void *f_name, char **file_name, char** args);
 /* initd process를 실행시킬 base thread */
 static struct thread* base;
 
+/* 파일 시스템 전체를 보호하는 lock. 내용을 바꾸지 않는 syscall은 읽기로 잡음 */
+static struct rwlock file_lock;
+
+/* file_lock 초기화, syscall_init에서 한 번 호출.
+   clone()으로 만든 스레드 목록(threads)과 thread_cnt는 인터럽트를 끄고 접근 */
+void
+process_init_file_lock(void){
+	rwlock_init(&file_lock, true);
+	rwlock_set_name(&file_lock, "file_lock");
+}
+
+/* 현재 스레드가 file_lock을 (읽기든 쓰기든) 잡고 있는지 */
+bool
+process_file_held(void){
+	return rwlock_held_by_current_thread(&file_lock);
+}
+
 void
-process_lock_file(){
-	if(!lock_held_by_current_thread(&file_lock))
-		lock_acquire(&file_lock);
+process_lock_file(void){
+	if(!rwlock_held_by_current_thread(&file_lock))
+		rwlock_write_acquire(&file_lock);
 }
 
 void
-process_release_file(){
-	if(lock_held_by_current_thread(&file_lock))
-		lock_release(&file_lock);
+process_lock_file_read(void){
+	if(!rwlock_held_by_current_thread(&file_lock))
+		rwlock_read_acquire(&file_lock);
+}
+
+void
+process_release_file(void){
+	if(rwlock_held_by_current_thread(&file_lock))
+		rwlock_release(&file_lock);
 }
 
 /* General process initializer for initd and other process. */
@@ -70,6 +100,18 @@ add_child(struct thread* parent, struct thread* child){
 	ASSERT(parent != NULL);
 	ASSERT(child != NULL);
 	list_push_back(&parent->child_list, &child->child_elem);
+	child->parent = parent;
+}
+
+/* 자원 사용량 SRC를 DST에 더하는 함수 */
+static void
+rusage_add (struct rusage *dst, const struct rusage *src) {
+	dst->user_ticks += src->user_ticks;
+	dst->kernel_ticks += src->kernel_ticks;
+	dst->voluntary_switches += src->voluntary_switches;
+	dst->involuntary_switches += src->involuntary_switches;
+	dst->sectors_read += src->sectors_read;
+	dst->sectors_written += src->sectors_written;
 }
 
 /* Starts the first userland program, called "initd", loaded from FILE_NAME.
@@ -89,8 +131,6 @@ process_create_initd (const char *file_name) {
 		return TID_ERROR;
 	strlcpy (fn_copy, file_name, PGSIZE);
 
-	lock_init(&file_lock);
-
 	/* (P2) child process를 list에 추가하는 동안 child process가 종료되는걸 방지하기 위한 lock */
 
 	base = thread_current();
@@ -209,6 +249,8 @@ __do_fork (void *aux) {
 	struct intr_frame if_;
 	struct thread *parent = (struct thread*) aux;
 	struct thread *current = thread_current ();
+	/* clone()으로 만든 스레드가 fork하면 프로세스 전체를 복제 */
+	struct thread *owner = parent->leader;
 
 	/* TODO: somehow pass the parent_if. (i.e. process_fork()'s if_) */
 	struct intr_frame *parent_if = &parent->parent_if;
@@ -229,7 +271,14 @@ __do_fork (void *aux) {
 	process_activate (current);
 #ifdef VM
 	supplemental_page_table_init (&current->spt);
-	if (!supplemental_page_table_copy (&current->spt, &parent->spt))
+
+	/* 부모의 다른 스레드가 복사 중에 SPT를 바꾸지 못하게 */
+	process_lock_file_read();
+	lock_acquire (&owner->spt.lock);
+	succ = supplemental_page_table_copy (&current->spt, &owner->spt);
+	lock_release (&owner->spt.lock);
+	process_release_file();
+	if (!succ)
 		goto error;
 #else
 	if (!pml4_for_each (parent->pml4, duplicate_pte, parent))
@@ -242,12 +291,17 @@ __do_fork (void *aux) {
 	 * TODO:       in include/filesys/file.h. Note that parent should not return
 	 * TODO:       from the fork() until this function successfully duplicates
 	 * TODO:       the resources of parent.*/
+	/* 부모의 다른 스레드가 FD를 여닫는 중일 수 있음 */
+	process_lock_file();
+	lock_acquire(&owner->fd_lock);
 	for(int i = 0; i < FD_MAX; i++){
-		struct file* fd = parent->fds[i];
+		struct file* fd = owner->fds[i];
 		if(fd == NULL) continue;
 
 		current->fds[i] = file_duplicate(fd);
 	}
+	lock_release(&owner->fd_lock);
+	process_release_file();
 	process_init (parent);
 
 	/* Finally, switch to the newly created process. */
@@ -274,6 +328,10 @@ process_exec (void *f_name) {
 	_if.cs = SEL_UCSEG;
 	_if.eflags = FLAG_IF | FLAG_MBS;
 
+	/* 다른 스레드가 쓰는 주소 공간은 바꿀 수 없음 */
+	if (thread_current ()->leader->thread_cnt > 1)
+		return -1;
+
 	// (P2) 유저 공간에 있는 cmd_line을 커널 공간으로 복사
 	char *cmd_line_copy = palloc_get_page(0);
     if(cmd_line_copy == NULL) 
@@ -314,65 +372,208 @@ process_wait (tid_t child_tid) {
 
 	/* P2. 변수 선언 */
 	struct thread *cur = thread_current();
-    struct list_elem *e;
 
 	// msg("%s waiting %d thread", cur->name, child_tid);
 	if(child_tid == TID_ERROR) return -1;
 
-	/* P2. 자식리스트 순회 */
-    for(e = list_begin(&cur->child_list); e != list_end(&cur->child_list); e = list_next(e)){
-        struct thread *child = list_entry(e, struct thread, child_elem);
+	/* P2. tid 인덱스로 직접 만든 자식 찾기
+	 * 자식은 부모가 wait 할 때까지 process_exit에서 대기하므로 인덱스에 남아 있음
+	 * 부모가 먼저 끝나면 release_children()이 parent를 지우므로
+	 * 같은 주소에 새로 만들어진 스레드와 헷갈리지 않음 */
+	struct thread *child = thread_get_by_tid(child_tid);
+	if(child == NULL || child->parent != cur)
+		return -1; // P2. 자식이 아니거나 유효하지 않은 pid인 경우
 
-		/* P2. 자식리스트에서 직접 만든 자식 찾기 */
-        if (child->tid == child_tid){
-            if (child->has_been_waited) return -1; // P2. 이미 기다렸던 자식 제외
+	if (child->has_been_waited) return -1; // P2. 이미 기다렸던 자식 제외
 
-            child->has_been_waited = true; // P2. 한 번 기다린 자식이라는 정보 저장
+	child->has_been_waited = true; // P2. 한 번 기다린 자식이라는 정보 저장
 
-            sema_down(&child->wait_sema); // P2. 자식이 살아있으면 부모 block
+	/* P2. 자식이 살아있으면 부모 block
+	 * 같은 프로세스의 다른 스레드가 exit하면 기다리지 않고 돌아감 */
+	if(!sema_down_killable(&child->wait_sema))
+		return -1;
 
-            int status = child->exit_status; // P2. 자식이 부모에게 전달할 종료 상태 정보 저장
+	int status = child->exit_status; // P2. 자식이 부모에게 전달할 종료 상태 정보 저장
 
-            list_remove(&child->child_elem); // P2. 해당 자식을 자식 리스트에서 제거
+	/* 자식과 자식이 기다린 자손들의 자원 사용량을 합산 */
+	rusage_add(&cur->child_usage, &child->usage);
+	rusage_add(&cur->child_usage, &child->child_usage);
 
-			sema_up(&child->exit_sema); // P2. 자식이 죽을 수 있게 하기
+	list_remove(&child->child_elem); // P2. 해당 자식을 자식 리스트에서 제거
+	child->parent = NULL;
 
-            return status;
-        }
-    }
-    return -1; // P2. 자식이 아니거나 유효하지 않은 pid인 경우
+	sema_up(&child->exit_sema); // P2. 자식이 죽을 수 있게 하기
+
+	return status;
+}
+
+/* Arguments of start_clone(), on the stack of process_clone(). */
+struct clone_args {
+	struct thread *leader;      /* Process the new thread joins. */
+	uintptr_t start;            /* User entry point. */
+	uint64_t arg0, arg1;        /* Passed in rdi and rsi. */
+	uintptr_t stack;            /* Top of the user stack. */
+	struct semaphore started;   /* Up'd once the thread is set up. */
+};
+
+/* Starts a new thread in the current process that runs
+ * START (ARG0, ARG1) in user mode, on the stack whose top is
+ * STACK.  The thread shares the address space, the supplemental
+ * page table and the file descriptors of the process.  START
+ * must not return, but end the thread with exit().  Returns the
+ * new thread's tid, or TID_ERROR if it cannot be created. */
+tid_t
+process_clone (void *start, uint64_t arg0, uint64_t arg1, void *stack) {
+	struct thread *curr = thread_current ();
+	struct clone_args args;
+	tid_t tid;
+
+	if (curr->pml4 == NULL || !is_user_vaddr (start) || !is_user_vaddr (stack))
+		return TID_ERROR;
+
+	args.leader = curr->leader;
+	args.start = (uintptr_t) start;
+	args.arg0 = arg0;
+	args.arg1 = arg1;
+	args.stack = (uintptr_t) stack;
+	sema_init (&args.started, 0);
+
+	tid = thread_create (args.leader->name, thread_get_priority (),
+			start_clone, &args);
+	if (tid != TID_ERROR)
+		sema_down (&args.started);
+	return tid;
+}
+
+/* A thread function that enters user mode for process_clone(). */
+static void
+start_clone (void *args_) {
+	struct clone_args *args = args_;
+	struct thread *curr = thread_current ();
+	struct thread *leader = args->leader;
+	struct intr_frame if_;
+	enum intr_level old_level;
+
+	memset (&if_, 0, sizeof if_);
+	if_.ds = if_.es = if_.ss = SEL_UDSEG;
+	if_.cs = SEL_UCSEG;
+	if_.eflags = FLAG_IF | FLAG_MBS;
+	if_.rip = args->start;
+	if_.R.rdi = args->arg0;
+	if_.R.rsi = args->arg1;
+	/* 함수가 막 호출된 것처럼 rsp + 8을 16바이트에 맞춤 */
+	if_.rsp = (args->stack & ~(uintptr_t) 0xf) - sizeof (void *);
+
+	curr->is_kernel = false;
+	curr->leader = leader;
+	curr->pml4 = leader->pml4;
+	if (leader->pwd != NULL)
+		curr->pwd = dir_reopen (leader->pwd);
+	process_activate (curr);
+
+	old_level = intr_disable ();
+	leader->thread_cnt++;
+	list_push_back (&leader->threads, &curr->thread_elem);
+	/* 프로세스가 이미 끝나는 중이면 이 스레드도 곧 종료 */
+	curr->dying = leader->dying;
+	intr_set_level (old_level);
+
+	/* 이후로 ARGS는 process_clone()이 돌아가면서 사라짐 */
+	sema_up (&args->started);
+	do_iret (&if_);
+	NOT_REACHED ();
+}
+
+/* Waits for thread TID, made by process_clone() in the current
+ * process, to exit and returns its exit status.  Returns -1 at
+ * once if TID is not such a thread, is the caller, or has
+ * already been joined. */
+int
+process_join (tid_t tid) {
+	struct thread *curr = thread_current ();
+	struct thread *leader = curr->leader;
+	struct thread *t = NULL;
+	enum intr_level old_level;
+	struct list_elem *e;
+	int status;
+
+	old_level = intr_disable ();
+	for (e = list_begin (&leader->threads); e != list_end (&leader->threads);
+			e = list_next (e)) {
+		struct thread *cand = list_entry (e, struct thread, thread_elem);
+
+		if (cand->tid == tid && cand != curr && !cand->has_been_waited) {
+			cand->has_been_waited = true;
+			t = cand;
+			break;
+		}
+	}
+	intr_set_level (old_level);
+	if (t == NULL)
+		return -1;
+
+	/* 프로세스가 종료되면 T를 기다리지 않고 돌아감 */
+	if (!sema_down_killable (&t->wait_sema))
+		return -1;
+	status = t->exit_status;
+
+	old_level = intr_disable ();
+	list_remove (&t->thread_elem);
+	intr_set_level (old_level);
+
+	sema_up (&t->exit_sema);
+	return status;
 }
 
 /* Exit the process. This function is called by thread_exit (). */
 void
 process_exit (void) {
 	struct thread *curr = thread_current ();
+	enum intr_level old_level;
+	bool last;
 	/* TODO: Your code goes here.
 	 * TODO: Implement process termination message (see
 	 * TODO: project2/process_termination.html).
 	 * TODO: We recommend you to implement process resource cleanup here. */
 
+	if (curr->leader != curr) {
+		exit_clone (curr);
+		return;
+	}
+
 	/* (P2) user level process인 경우 종료 시 메시지 표시 
 	 * exit() 호출 외에 다른 방법으로 종료됐을 때도 커버 필요할지 몰라서 process 단으로 이동 */
 	lock_acquire(&curr->fork_lock);
 	if(!curr->is_kernel)
 		printf ("%s: exit(%d)\n", curr->name, curr->exit_status);
 
+	/* clone()으로 만든 스레드가 모두 끝나야 주소 공간과 FD를 정리할 수 있음 */
+	old_level = intr_disable ();
+	last = --curr->thread_cnt == 0;
+	intr_set_level (old_level);
+	if (!last) {
+		kill_clones (curr);
+		sema_down (&curr->threads_done);
+	}
+
 	/* P2. 열려 있는 FD 닫기 -> EXTRA: 0,1도 닫기 */
 	for(int i = 2; i < FD_MAX; i++){
-		if(curr->fds[i] != NULL){
+		lock_acquire(&curr->fd_lock);
+		struct file *f = curr->fds[i];
+		curr->fds[i] = NULL;
+		lock_release(&curr->fd_lock);
+		if(f != NULL){
 			process_lock_file();
-			file_close(curr->fds[i]);
+			file_close(f);
 			process_release_file();
-			curr->fds[i] = NULL;
 		}
     }
 
 	/* P2. 현재 실행 중인 파일 닫기 */
 	if(curr->running_file != NULL){
-		lock_acquire(&file_lock);
+		process_lock_file();
 		file_close(curr->running_file);
-		lock_release(&file_lock);
+		process_release_file();
 	}
 
 	struct supplemental_page_table *spt = &curr->spt;
@@ -402,12 +603,119 @@ process_exit (void) {
 
 	/* P2. 프로세스 자원 정리 */
 	process_cleanup ();
+	release_clones (curr);
+	release_children (curr);
 
 	sema_up(&curr->wait_sema); // P2. 자식의 죽음을 알려 부모 깨우기
 	sema_down(&curr->exit_sema); // P2. 부모 프로세스가 죽을 때까지 대기
 	lock_release(&curr->fork_lock);
 }
 
+/* Ends the current thread, with exit status -1, if its process
+ * is exiting.  Called just before returning to user mode, where
+ * the thread holds no locks. */
+void
+process_exit_if_dying (void) {
+	struct thread *curr = thread_current ();
+
+	if (!curr->dying)
+		return;
+	intr_enable ();
+	curr->exit_status = -1;
+	thread_exit ();
+}
+
+/* Ends CURR, a thread made by process_clone().  The address
+ * space and file descriptors belong to the process, so CURR only
+ * drops its reference; if it is the last thread, the main thread
+ * can now tear them down.  CURR then waits to be joined, or for
+ * the process to end. */
+static void
+exit_clone (struct thread *curr) {
+	struct thread *leader = curr->leader;
+	enum intr_level old_level;
+	bool last;
+
+	dir_close (curr->pwd);
+	curr->pwd = NULL;
+
+	/* 타이머 인터럽트가 다시 활성화하지 않도록 먼저 NULL로 */
+	curr->pml4 = NULL;
+	pml4_activate (NULL);
+
+	old_level = intr_disable ();
+	rusage_add (&leader->usage, &curr->usage);
+	last = --leader->thread_cnt == 0;
+	intr_set_level (old_level);
+	if (last)
+		sema_up (&leader->threads_done);
+	release_children (curr);
+
+	sema_up (&curr->wait_sema);
+	sema_down (&curr->exit_sema);
+}
+
+/* Lets the threads that LEADER made with process_clone() and
+ * that nobody joined finish exiting.  Called once every thread of
+ * the process but LEADER has exited. */
+static void
+release_clones (struct thread *leader) {
+	for (;;) {
+		enum intr_level old_level = intr_disable ();
+		struct thread *t = NULL;
+
+		if (!list_empty (&leader->threads))
+			t = list_entry (list_pop_front (&leader->threads),
+					struct thread, thread_elem);
+		intr_set_level (old_level);
+		if (t == NULL)
+			break;
+		sema_up (&t->exit_sema);
+	}
+}
+
+/* Lets the children of PARENT that PARENT did not wait for
+ * finish exiting, and clears their parent pointer so that
+ * process_wait() cannot match them against a new thread that
+ * happens to reuse PARENT's page.  Children add themselves to
+ * the list only while PARENT waits for them to start, so PARENT,
+ * which is exiting, is the only one that touches it here. */
+static void
+release_children (struct thread *parent) {
+	while (!list_empty (&parent->child_list)) {
+		struct thread *child = list_entry (list_pop_front (&parent->child_list),
+				struct thread, child_elem);
+
+		child->parent = NULL;
+		sema_up (&child->exit_sema);
+	}
+}
+
+/* Marks every thread of LEADER's process dying, so that each one
+ * exits instead of going back to user mode, and wakes those that
+ * sleep on a futex or in sema_down_killable(): wait(), join()
+ * and read() from the keyboard.  Called by LEADER as it exits,
+ * before waiting for the other threads.  The other waits a thread
+ * may be in, for locks, disk I/O or a child that is being forked,
+ * end on their own. */
+static void
+kill_clones (struct thread *leader) {
+	enum intr_level old_level = intr_disable ();
+	struct list_elem *e;
+
+	leader->dying = true;
+	for (e = list_begin (&leader->threads); e != list_end (&leader->threads);
+			e = list_next (e)) {
+		struct thread *t = list_entry (e, struct thread, thread_elem);
+
+		t->dying = true;
+		sema_kill_wait (t);
+	}
+	intr_set_level (old_level);
+
+	futex_wake_space (leader->pml4);
+}
+
 /* Free the current process's resources. */
 static void
 process_cleanup (void) {
@@ -602,16 +910,16 @@ load (const char *file_n, struct intr_frame *if_) {
 	process_activate (thread_current ());
 
 	/* Open executable file. */
-	lock_acquire(&file_lock);
+	process_lock_file();
 	file = filesys_open (file_name);
 	if (file == NULL) {
 		printf ("load: %s: open failed\n", file_name);
 		goto done;
 	}
-	lock_release(&file_lock);
+	process_release_file();
 
 	/* Read and verify executable header. */
-	lock_acquire(&file_lock);
+	process_lock_file();
 	if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
 			|| memcmp (ehdr.e_ident, "\177ELF\2\1\1", 7)
 			|| ehdr.e_type != 2
@@ -622,7 +930,7 @@ load (const char *file_n, struct intr_frame *if_) {
 		printf ("load: %s: error loading executable\n", file_name);
 		goto done;
 	}
-	lock_release(&file_lock);
+	process_release_file();
 
 	/* Read program headers. */
 	file_ofs = ehdr.e_phoff;
@@ -631,7 +939,7 @@ load (const char *file_n, struct intr_frame *if_) {
 
 		if (file_ofs < 0 || file_ofs > file_length (file))
 			goto done;
-		lock_acquire(&file_lock);
+		process_lock_file();
 		file_seek (file, file_ofs);
 
 		if (file_read (file, &phdr, sizeof phdr) != sizeof phdr)
@@ -676,7 +984,7 @@ load (const char *file_n, struct intr_frame *if_) {
 					goto done;
 				break;
 		}
-		lock_release(&file_lock);
+		process_release_file();
 	}
 
 	/* Set up stack. */
@@ -690,15 +998,15 @@ load (const char *file_n, struct intr_frame *if_) {
 	 * TODO: Implement argument passing (see project2/argument_passing.html). */
 	pass_arguments(if_, file_name, args);
 
-	lock_acquire(&file_lock);
+	process_lock_file();
 	/* (P2) deny_write 추가 */
 	file_deny_write(file);
-	lock_release(&file_lock);
+	process_release_file();
 	success = true;
 done:
 	/* We arrive here whether the load is successful or not. */
 	t->running_file = file;
-	if(lock_held_by_current_thread(&file_lock)) lock_release(&file_lock);
+	process_release_file();
 	return success;
 }
 
@@ -859,18 +1167,22 @@ lazy_load_segment (struct page *page, void *aux) {
 	struct segment_aux *lazy_aux = (struct segment_aux *) aux; // [P3-2] load_segment에서 전달받은 보조 정보 구조체
 	uint8_t *kva = page->frame->kva; // [P3-2] 페이지의 물리 메모리 주소
 
-	/* [P3-2] 파일 시스템 동기화 lock */
-	lock_acquire(&file_lock);
+	/* [P3-2] 파일 시스템 동기화 lock (syscall 도중의 fault면 이미 보유 중) */
+	bool lock_held = rwlock_held_by_current_thread(&file_lock);
+	if(!lock_held)
+		rwlock_read_acquire(&file_lock);
 	if(file_read_at(lazy_aux->file, kva, lazy_aux->page_read_bytes, lazy_aux->offset) != (int) lazy_aux->page_read_bytes){ // [P3-2] 파일 읽기 실패 여부 판단
-		lock_release(&file_lock);
+		if(!lock_held)
+			rwlock_release(&file_lock);
 		palloc_free_page(page->frame->kva); // [P3-2] 물리 메모리 주소 메모리 해제
-		free(lazy_aux); // [P3-2] 보조 정보 구조체 메모리 해제
+		kmem_cache_free(segment_aux_cache, lazy_aux); // [P3-2] 보조 정보 구조체 메모리 해제
 		return false;
 	}
-	lock_release(&file_lock);
+	if(!lock_held)
+		rwlock_release(&file_lock);
 
 	memset(kva + lazy_aux->page_read_bytes, 0, lazy_aux->page_zero_bytes); // [P3-2] 남은 부분을 0으로 초기화
-	free(lazy_aux); // [P3-2] 보조 정보 구조체 메모리 해제
+	kmem_cache_free(segment_aux_cache, lazy_aux); // [P3-2] 보조 정보 구조체 메모리 해제
 	return true; 
 }
 
@@ -903,7 +1215,7 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
 		/* TODO: Set up aux to pass information to the lazy_load_segment. */
-		struct segment_aux *aux = malloc(sizeof(struct segment_aux)); // [P3-2] aux 구조체 동적 할당
+		struct segment_aux *aux = kmem_cache_alloc(segment_aux_cache); // [P3-2] aux 구조체 동적 할당
 		
 		/* [P3-2] aux에 정보 저장 */
 		aux->file = file;
@@ -913,7 +1225,7 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 		aux->writable = writable;   
 
 		if (!vm_alloc_page_with_initializer (VM_ANON, upage, writable, lazy_load_segment, aux)){
-			free(aux); // [P3-2] 할당 실패시 aux 메모리 해제
+			kmem_cache_free(segment_aux_cache, aux); // [P3-2] 할당 실패시 aux 메모리 해제
 			return false;
 		}
 
@@ -20,6 +20,7 @@
 #include "devices/input.h"
 
 #include "userprog/process.h"
+#include "userprog/futex.h"
 
 /* P2. 파일 계열 함수를 여러 프로세스가 동시에 호출하지 못하게 동기화하는 Lock */
 // struct lock file_lock;
@@ -40,7 +41,24 @@ void syscall_handler (struct intr_frame *);
 #define MSR_LSTAR 0xc0000082        /* Long mode SYSCALL target */
 #define MSR_SYSCALL_MASK 0xc0000084 /* Mask for the eflags */
 
-#define is_invalid_fd(fd) (fd < 2 || fd >= FD_MAX || cur->fds == NULL || cur->fds[fd] == NULL)
+/* Returns the file open as FD in the current process, or NULL if
+   FD is not open.  The fd table is shared by all threads of the
+   process and guarded by the leader's fd_lock.  The caller must
+   hold the file lock, for reading or writing, and may use the file
+   only until it releases the lock: close() removes the file from
+   the table first but frees it only under the lock for writing. */
+static struct file *
+fd_file (int fd) {
+	struct thread *leader = thread_current ()->leader;
+	struct file *f;
+
+	if (fd < 2 || fd >= FD_MAX)
+		return NULL;
+	lock_acquire (&leader->fd_lock);
+	f = leader->fds[fd];
+	lock_release (&leader->fd_lock);
+	return f;
+}
 
 void
 syscall_init (void) {
@@ -49,7 +67,8 @@ syscall_init (void) {
 	write_msr(MSR_LSTAR, (uint64_t) syscall_entry);
 
 	/* Lock 초기화 */
-	// lock_init(&file_lock);
+	process_init_file_lock();
+	futex_init();
 
 	/* The interrupt service rountine should not serve any interrupts
 	 * until the syscall_entry swaps the userland stack to the kernel
@@ -136,11 +155,32 @@ syscall_handler (struct intr_frame *f) {
         case SYS_SYMLINK:
             f->R.rax = symlink((char*)f->R.rdi, (char *)f->R.rsi);
             break;
+        case SYS_SCHED_DEADLINE:
+            f->R.rax = sched_deadline((unsigned)f->R.rdi, (unsigned)f->R.rsi, (unsigned)f->R.rdx);
+            break;
+        case SYS_GETRUSAGE:
+            f->R.rax = getrusage((int)f->R.rdi, (struct rusage *)f->R.rsi);
+            break;
+        case SYS_FUTEX_WAIT:
+            f->R.rax = futex_wait((int *)f->R.rdi, (int)f->R.rsi);
+            break;
+        case SYS_FUTEX_WAKE:
+            f->R.rax = futex_wake((int *)f->R.rdi, (int)f->R.rsi);
+            break;
+        case SYS_CLONE:
+            f->R.rax = clone((void *)f->R.rdi, f->R.rsi, f->R.rdx, (void *)f->R.r10);
+            break;
+        case SYS_JOIN:
+            f->R.rax = join((pid_t)f->R.rdi);
+            break;
             
         default:
             printf("Unknown system call: %lu\n", syscall_num);
             thread_exit();
     }
+
+    /* 프로세스가 끝나는 중이면 유저 모드로 돌아가지 않고 종료 */
+    process_exit_if_dying();
 	/*
 	printf ("system call!\n");
 	printf ("intr vector no.%ld\n", f->vec_no);
@@ -197,7 +237,7 @@ bool create(const char *file, unsigned initial_size){
     // P2. 파일 생성 & syscall 동기화
 	process_lock_file();
     bool result = filesys_create(file, initial_size);
-    process_release_file(&file_lock);
+    process_release_file();
 	
     return result;
 }
@@ -208,9 +248,9 @@ bool remove(const char *file){
     is_valid_ptr(file);
 
     // P2. 파일 삭제 & syscall 동기화
-	process_lock_file(&file_lock);
+	process_lock_file();
     bool result = filesys_remove(file);
-    process_release_file(&file_lock);
+    process_release_file();
 
     return result;
 }
@@ -219,45 +259,50 @@ bool remove(const char *file){
 int open(const char *file){
     // P2. 함수 인자 유효성 검사
     is_valid_ptr(file);
-    struct thread *cur = thread_current();
+    struct thread *cur = thread_current()->leader;
 
 
 	// P2. 파일 열기 & syscall 동기화
-	process_lock_file(&file_lock);
+	process_lock_file();
     struct file *opened_file = filesys_open(file);
-	process_release_file(&file_lock);
-    if(opened_file == NULL) return -1;
+    if(opened_file == NULL){
+        process_release_file();
+        return -1;
+    }
 
     // P2. FD 테이블의 빈 자리에 저장 (표준 입출력 0,1 제외) -> EXTRA: 0,1도 포함시키기
+    // FD 테이블은 같은 프로세스의 스레드끼리 공유하므로 fd_lock 안에서 자리를 잡음
+    lock_acquire(&cur->fd_lock);
     for(int fd = 2; fd < FD_MAX; fd++){
         if(cur->fds[fd] == NULL){
             cur->fds[fd] = opened_file;
+            lock_release(&cur->fd_lock);
+            process_release_file();
             return fd;
         }
     }
+    lock_release(&cur->fd_lock);
 
     // P2. 파일 닫기 & syscall 동기화
-	process_lock_file(&file_lock);
     file_close(opened_file);
-    process_release_file(&file_lock);
+    process_release_file();
     return -1;
 }
 
 /* P2. 파일 사이즈를 반환하는 system call */
 int filesize(int fd){
-    struct thread *cur = thread_current();
-
     // P2. FD가 유효한지 검사 -> EXTRA: fd<0
     if(fd < 2 || fd >= FD_MAX) return -1;
 
-	// P2. 해당 FD가 열린 파일인지 검사
-    struct file *f = cur->fds[fd];
-    if(f == NULL) exit(-1);
-
-    // P2. 파일 크기 반환 & syscall 동기화
-	process_lock_file(&file_lock);
+    // P2. 파일 크기 반환 & syscall 동기화, 다른 스레드가 닫을 수 있으므로 lock 안에서 FD 확인
+	process_lock_file_read();
+    struct file *f = fd_file(fd);
+    if(f == NULL){
+        process_release_file();
+        exit(-1);
+    }
     int result = file_length(f);
-    process_release_file(&file_lock);
+    process_release_file();
     return result; 
 }
 
@@ -271,21 +316,21 @@ int read(int fd, void *buffer, unsigned size){
     // [P3-2] buffer가 걸친 모든 주소가 쓰기 가능한 주소인지 확인
     for(unsigned i = 0; i < size; i++) is_valid_ptr_writable((uint8_t *)buffer + i);
 
-    struct thread *cur = thread_current();
-
 	// P2. FD가 stdin인 경우
     if(fd == 0){
-        for(unsigned i = 0; i < size; i++) ((uint8_t *)buffer)[i] = input_getc();
+        /* 프로세스가 종료 중이면 읽은 데까지만 반환, 유저 모드로 돌아가기 전에 종료됨 */
+        for(unsigned i = 0; i < size; i++)
+            if(!input_getc_killable((uint8_t *)buffer + i))
+                return i;
         return size;
     }
-	
-	// P2. FD가 유효하지 않은 경우 -> EXTRA: fd<0
-	if(is_invalid_fd(fd)) return -1;
 
-    // P2. 파일 읽기 & syscall 동기화
-	process_lock_file(&file_lock);
-    int result = file_read(cur->fds[fd], buffer, size);
-    process_release_file(&file_lock);
+    // P2. 파일 읽기 & syscall 동기화, 파일 위치는 file마다 lock으로 보호하므로 읽기로 잡음
+	process_lock_file_read();
+    struct file *f = fd_file(fd);
+	// P2. FD가 유효하지 않은 경우 -> EXTRA: fd<0
+    int result = f != NULL ? file_read(f, buffer, size) : -1;
+    process_release_file();
     return result;
 }
 
@@ -294,73 +339,67 @@ int write(int fd, const void *buffer, unsigned size){
     // P2. 함수 인자 유효성 검사
     is_valid_ptr(buffer);
 
-    struct thread *cur = thread_current();
-
     // P2. FD가 stdout인 경우
     if(fd == 1){
         putbuf((char *) buffer, size);
         return size;
     }
 
-    // P2. FD가 유효하지 않은 경우 -> EXTRA: fd<0
-    if(is_invalid_fd(fd)) return -1;
-	
     // P2. 파일 쓰기 & syscall 동기화
-	process_lock_file(&file_lock);
+	process_lock_file();
+    struct file *f = fd_file(fd);
     /* [P4-2] fd가 dir를 가리키면 write 불가 */
     int result = 0;
-    if(filesys_is_dir(cur->fds[fd]))
+    if(f == NULL || filesys_is_dir(f)) // P2. FD가 유효하지 않은 경우 -> EXTRA: fd<0
         result = -1;
     else
-        result = file_write(cur->fds[fd], buffer, size);
-    process_release_file(&file_lock);
+        result = file_write(f, buffer, size);
+    process_release_file();
     return result; 
 }
 
 /* P2. 열린 FD의 파일 포인터 위치를 이동하는 system call */
 void seek(int fd, unsigned position){
-    struct thread *cur = thread_current();
-
-    // P2. FD가 유효하지 않은 경우 -> EXTRA: fd<0
-    if(is_invalid_fd(fd)) return;
-
 	// P2. 파일 포인터 위치 이동 & syscall 동기화
 	process_lock_file();
-    file_seek(cur->fds[fd], position);
+    struct file *f = fd_file(fd);
+    // P2. FD가 유효하지 않은 경우 -> EXTRA: fd<0
+    if(f != NULL)
+        file_seek(f, position);
     process_release_file();
 }
 
 /* P2. 열린 FD의 파일 포인터 위치를 반환하는 system call */
 unsigned tell(int fd){
-    struct thread *cur = thread_current();
-
-    // P2. FD가 유효하지 않은 경우 -> EXTRA: fd<0
-    if(is_invalid_fd(fd)) return -1;
-
     // P2. 파일 포인터 위치 반환 & syscall 동기화
-	process_lock_file();
-	unsigned result = file_tell(cur->fds[fd]);
+	process_lock_file_read();
+    struct file *f = fd_file(fd);
+    // P2. FD가 유효하지 않은 경우 -> EXTRA: fd<0
+	unsigned result = f != NULL ? (unsigned) file_tell(f) : (unsigned) -1;
 	process_release_file();
 	return result;
 }
 
 /* P2. 파일을 닫는 system call */
 void close(int fd){
-    struct thread *cur = thread_current();
-
-    // P2. FD가 유효하지 않은 경우 -> EXTRA: fd<0
-    if(is_invalid_fd(fd)) return;
-
-    struct file *f = cur->fds[fd];
-    if(f == NULL) return;
-
-    // P2. 파일 닫기 & syscall 동기화
-    process_lock_file();
-    file_close(f);
-    process_release_file();
+    struct thread *leader = thread_current()->leader;
+    struct file *f = NULL;
+
+    // P2. FD 테이블에서 현재 FD 제거 (FD가 유효하지 않은 경우 무시)
+    // 다른 스레드가 먼저 닫았을 수 있으므로 fd_lock 안에서 확인
+    if(fd >= 2 && fd < FD_MAX){
+        lock_acquire(&leader->fd_lock);
+        f = leader->fds[fd];
+        leader->fds[fd] = NULL;
+        lock_release(&leader->fd_lock);
+    }
 
-    // P2. FD 테이블에서 현재 FD 제거
-    cur->fds[fd] = NULL;
+    // P2. 파일 닫기 & syscall 동기화, 읽기로 f를 쓰고 있는 스레드가 끝날 때까지 기다림
+    if(f != NULL){
+        process_lock_file();
+        file_close(f);
+        process_release_file();
+    }
 }
 
 /* P2. 함수 인자가 유효한지 검사하는 함수 */ 
@@ -372,24 +411,16 @@ void is_valid_ptr(const void *ptr){
 }
 /* P3. mmap system call */
 void *mmap(void *addr, size_t length, int writable, int fd, off_t offset) {
-    struct thread *cur = thread_current();
-
     // P3.addr 유효성 체크
     if (addr == NULL || pg_ofs(addr) != 0 || length == 0)
         return NULL;
 
-    // P3. FD가 유효하지 않은 경우(stdio 제외)
-    if (fd < 2 || fd >= FD_MAX || cur->fds[fd] == NULL)
-        return NULL;
-
-    struct file *file = cur->fds[fd];
-    if (file == NULL)
-        return NULL;
-
     // P3. 파일 매핑 & syscall 동기화
-    process_lock_file(&file_lock);
-    void *mapped_addr = do_mmap(addr, length, writable, file, offset);
-    process_release_file(&file_lock);
+    process_lock_file();
+    // P3. FD가 유효하지 않은 경우(stdio 제외)
+    struct file *file = fd_file(fd);
+    void *mapped_addr = file != NULL ? do_mmap(addr, length, writable, file, offset) : NULL;
+    process_release_file();
 
     return mapped_addr;
 }
@@ -400,9 +431,9 @@ void munmap(void *addr) {
     if (addr == NULL || pg_ofs(addr) != 0)
         return;
 
-    process_lock_file(&file_lock);
+    process_lock_file();
     do_munmap(addr);
-    process_release_file(&file_lock);
+    process_release_file();
 }
 
 bool is_valid_dir_name(const char* dir);
@@ -413,9 +444,9 @@ bool chdir(const char *dir){
 
     bool success;
 
-    process_lock_file(&file_lock);
+    process_lock_file();
     success = filesys_change_dir(dir);
-    process_release_file(&file_lock);
+    process_release_file();
 
     return success;
 }
@@ -426,45 +457,41 @@ bool mkdir(const char *dir){
     
     bool success;
 
-    process_lock_file(&file_lock);
+    process_lock_file();
     success = filesys_create_dir(dir);
-    process_release_file(&file_lock);
+    process_release_file();
 
     return success;
 }
 
 bool readdir(int fd, char *name){
-    struct thread* cur = thread_current();
-
-    if(is_invalid_fd(fd)) 
-        return false;
-
     bool success;
-    process_lock_file(&file_lock);
+    /* 디렉터리 위치는 file의 위치 lock으로 보호하므로 읽기로 잡음 */
+    process_lock_file_read();
 
-    success = filesys_read_dir(cur->fds[fd], name);
+    success = filesys_read_dir(fd_file(fd), name);
 
-    process_release_file(&file_lock);
+    process_release_file();
     return success;
 }
 
 bool isdir(int fd){
     bool success;
-    process_lock_file(&file_lock);
+    process_lock_file_read();
 
-    success = filesys_is_dir(thread_current()->fds[fd]);
+    success = filesys_is_dir(fd_file(fd));
 
-    process_release_file(&file_lock);
+    process_release_file();
     return success;
 }
 
 int inumber(int fd){
     int result;
-    process_lock_file(&file_lock);
+    process_lock_file_read();
 
-    result = filesys_inumber(thread_current()->fds[fd]);
+    result = filesys_inumber(fd_file(fd));
 
-    process_release_file(&file_lock);
+    process_release_file();
     return result;
 }
 
@@ -475,22 +502,57 @@ int symlink(const char *target, const char *linkpath){
     if(linkpath == NULL || strlen(linkpath) == 0)
         return -1;
 
-    process_lock_file(&file_lock);
+    process_lock_file();
 
     result = filesys_symlink(target, linkpath);
 
-    process_release_file(&file_lock);
+    process_release_file();
     return result;
 }
 
+/* 현재 스레드를 EDF 실시간 클래스로 옮기는 system call (tick 단위)
+   runtime이 0이면 일반 클래스로 복귀, 허가 제어에 실패하면 -1 */
+int sched_deadline(unsigned runtime, unsigned deadline, unsigned period){
+    return thread_set_deadline(runtime, deadline, period) ? 0 : -1;
+}
+
+/* 현재 프로세스(RUSAGE_SELF) 또는 기다린 자식들(RUSAGE_CHILDREN)의
+   자원 사용량을 usage에 복사하는 system call */
+int getrusage(int who, struct rusage *usage){
+    struct thread *cur = thread_current();
+
+    // usage가 걸친 첫 주소와 끝 주소가 쓰기 가능한지 확인
+    is_valid_ptr_writable(usage);
+    is_valid_ptr_writable((uint8_t *)usage + sizeof *usage - 1);
+
+    if(who == RUSAGE_SELF)
+        *usage = cur->usage;
+    else if(who == RUSAGE_CHILDREN)
+        *usage = cur->child_usage;
+    else
+        return -1;
+    return 0;
+}
+
+/* 현재 프로세스에 start(arg0, arg1)을 stack 위에서 실행하는 스레드를 만드는 system call
+   새 스레드는 주소 공간과 FD를 공유하고, start는 돌아오지 말고 exit()으로 끝나야 함 */
+pid_t clone(void *start, uint64_t arg0, uint64_t arg1, void *stack){
+    return process_clone(start, arg0, arg1, stack);
+}
+
+/* clone()으로 만든 스레드가 끝나기를 기다려 종료 상태를 반환하는 system call */
+int join(pid_t tid){
+    return process_join(tid);
+}
+
 /* [P3-2] 쓰기 가능한 유저 주소인지 검사하는 함수 */
 void is_valid_ptr_writable(const void *ptr){
     if(ptr == NULL || !is_user_vaddr(ptr)) exit(-1); // [P3-2] NULL이거나 커널 주소 시 종료
     
-    struct page *p = spt_find_page(&thread_current()->spt, ptr);
+    struct page *p = spt_find_page(&thread_current()->leader->spt, ptr);
     if(p == NULL){
         if (!vm_claim_page((void *)ptr)) exit(-1); // [P3-2] Lazy allocation 실패 시 종료
-        p = spt_find_page(&thread_current()->spt, ptr);
+        p = spt_find_page(&thread_current()->leader->spt, ptr);
     }
 
     if(p == NULL || !p->writable) exit(-1); // [P3-2] 페이지가 없거나 쓰기 권한이 없으면 종료
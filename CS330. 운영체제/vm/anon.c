@@ -23,6 +23,7 @@ static const struct page_operations anon_ops = {
 static struct disk *swap_disk; // [P3-2] Swap 데이터를 저장하는 보조 저장 공간
 struct list swap_table; // [P3-2] 익명 페이지 swap용 리스트
 struct lock anon_lock; // [P3-2] 익명 페이지 Lock
+static struct kmem_cache *sector_cache; // swap table의 struct disk_sector용 cache
 /* Initialize the data for anonymous pages */
 void
 vm_anon_init (void) {
@@ -30,6 +31,8 @@ vm_anon_init (void) {
 	// msg("vm_anon_init");
 	list_init(&swap_table); // [P3-2] Swap table 초기화
 	lock_init(&anon_lock); // [P3-2] 익명 페이지 Lock 초기화
+	lock_set_name(&anon_lock, "anon_lock");
+	sector_cache = kmem_cache_create("disk_sector", sizeof (struct disk_sector), 0, NULL);
 
 	swap_disk = disk_get(1, 1);  // [P3-2] Swap disk 할당
     ASSERT(swap_disk != NULL); // [P3-2] Swap disk 할당 실패
@@ -38,7 +41,7 @@ vm_anon_init (void) {
 	
 	/* [P3-2] 모든 sector를 swap table에 추가 */
 	for(int i = 0; i < disk_sector_cnt; i++){
-		struct disk_sector *sector = malloc(sizeof(struct disk_sector)); // [P3-2] Sector 할당
+		struct disk_sector *sector = kmem_cache_alloc(sector_cache); // [P3-2] Sector 할당
 		ASSERT(sector != NULL); // [P3-2] Sector 할당 실패
 		
 		/* Sector 초기화 */
@@ -71,7 +71,7 @@ file_backed_init(struct page *page, void *aux){
 
 	/* P3. 해당 파일 위치 읽어서 kva에 저장 */
 	if(!file_read_at(file_page->file, kva, file_page->read_bytes, file_page->offset)){
-		free(data);
+		kmem_cache_free(segment_aux_cache, data);
 		// msg("file_backed_init: file_read_at failed");
 		return false;
 	}
@@ -79,7 +79,7 @@ file_backed_init(struct page *page, void *aux){
 	/* P3. zero padding (page size align)*/
 	memset(kva + file_page->read_bytes, 0, file_page->zero_bytes);
 	// msg("file_backed_init: memset done");
-	free(data);
+	kmem_cache_free(segment_aux_cache, data);
 	return true;
 }
 
@@ -192,7 +192,7 @@ do_mmap (void *addr, size_t length, int writable,
 		size_t page_zero_bytes = PGSIZE - page_read_bytes;
 
 		/* TODO: Set up aux to pass information to the lazy_load_segment. */
-		struct segment_aux *aux = malloc(sizeof(struct segment_aux)); // [P3-2] aux 구조체 동적 할당
+		struct segment_aux *aux = kmem_cache_alloc(segment_aux_cache); // [P3-2] aux 구조체 동적 할당
 		
 		/* [P3-2] aux에 정보 저장 */
 		aux->file = reopened_file;
@@ -205,12 +205,12 @@ do_mmap (void *addr, size_t length, int writable,
 
 		if (!vm_alloc_page_with_initializer (VM_FILE, upage,
 					writable, file_backed_init, aux)){
-			free(aux); // [P3-2] 할당 실패시 aux 메모리 해제
+			kmem_cache_free(segment_aux_cache, aux); // [P3-2] 할당 실패시 aux 메모리 해제
 			file_close(reopened_file);
 			return NULL;
 		}
 		// msg("do_mmap: mapped page: va: %p", upage);
-		struct page *page = spt_find_page(&thread_current()->spt, upage);
+		struct page *page = spt_find_page(&thread_current()->leader->spt, upage);
 		// msg("do_mmap: mapped page: va: %p, pa: %p", upage, page);
 		// msg("do_mmap: read_bytes: %d", read_bytes);
 		// msg("do_mmap: zero_bytes: %d", zero_bytes);
@@ -229,7 +229,7 @@ do_mmap (void *addr, size_t length, int writable,
 /* Do the munmap */
 void
 do_munmap (void *addr) {
-	struct page *page = spt_find_page(&thread_current()->spt, addr);
+	struct page *page = spt_find_page(&thread_current()->leader->spt, addr);
 	if (page == NULL)
 		return;
 
@@ -245,9 +245,9 @@ do_munmap (void *addr) {
 		write_back_if_dirty(page, file_page);
 
 		/* P3. spt에서 page 제거, destroy */
-		spt_remove_page(&thread_current()->spt, page);
+		spt_remove_page(&thread_current()->leader->spt, page);
 
-		page = spt_find_page(&thread_current()->spt, next_va);
+		page = spt_find_page(&thread_current()->leader->spt, next_va);
 	}
 	// msg("do_munmap: write back done");
 }
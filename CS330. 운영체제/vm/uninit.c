@@ -71,7 +71,7 @@ uninit_destroy (struct page *page) {
 	
 	 /* [P3-2] aux가 존재하면 메모리 해제 */
 	 if(uninit->aux != NULL){
-		free(uninit->aux);
+		kmem_cache_free(segment_aux_cache, uninit->aux);
 		uninit->aux = NULL;
 	}
 
@@ -1,17 +1,35 @@
 /* vm.c: Generic interface for virtual memory objects. */
 
 #include "threads/malloc.h"
+#include "threads/slab.h"
 #include "vm/vm.h"
 #include "vm/inspect.h"
 #include "threads/mmu.h"
 #include "vm/anon.h"
+#include "userprog/process.h"
 
 struct list frame_table; // [P3-2] 전역 프레임 테이블 선언
 
+/* Caches of struct page, struct frame and struct segment_aux. */
+static struct kmem_cache *vm_page_cache;
+static struct kmem_cache *frame_cache;
+struct kmem_cache *segment_aux_cache;
+
+/* Locks taken by spt_lock(). */
+#define SPT_LOCKED_SPT 1
+#define SPT_LOCKED_FILE 2
+
+static int spt_lock (struct supplemental_page_table *, bool claim);
+static void spt_unlock (struct supplemental_page_table *, int taken);
+
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
 void
 vm_init (void) {
+	vm_page_cache = kmem_cache_create ("page", sizeof (struct page), 0, NULL);
+	frame_cache = kmem_cache_create ("frame", sizeof (struct frame), 0, NULL);
+	segment_aux_cache = kmem_cache_create ("segment_aux",
+			sizeof (struct segment_aux), 0, NULL);
 	vm_anon_init ();
 	vm_file_init ();
 #ifdef EFILESYS  /* For project 4 */
@@ -41,6 +59,13 @@ page_get_type (struct page *page) {
 static struct frame *vm_get_victim (void);
 static bool vm_do_claim_page (struct page *page);
 static struct frame *vm_evict_frame (void);
+static bool handle_fault (struct supplemental_page_table *,
+		struct intr_frame *, void *addr, bool user, bool write,
+		bool not_present);
+
+/* Is PAGE in memory and mapped? */
+#define is_claimed(page) ((page)->frame != NULL \
+		&& pml4_get_page (thread_current ()->pml4, (page)->va) != NULL)
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
@@ -51,9 +76,10 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 
 	ASSERT (VM_TYPE(type) != VM_UNINIT)
 
-	struct supplemental_page_table *spt = &thread_current ()->spt;
+	struct supplemental_page_table *spt = &thread_current ()->leader->spt;
 
 	struct page *p = NULL; // [P3-2] 할당받을 페이지 변수 선언
+	int taken = spt_lock (spt, false);
 
 	/* Check wheter the upage is already occupied or not. */
 	if (spt_find_page (spt, upage) == NULL) {
@@ -62,8 +88,8 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 		 * TODO: should modify the field after calling the uninit_new. */
 
 		/* TODO: Insert the page into the spt. */
-		p = (struct page *)malloc(sizeof(struct page)); // [P3-2] 새로운 페이지 할당
-		if(p == NULL) return false; // [P3-2] 페이지 할당 실패 시 false 반환
+		p = kmem_cache_alloc(vm_page_cache); // [P3-2] 새로운 페이지 할당
+		if(p == NULL) goto err; // [P3-2] 페이지 할당 실패 시 false 반환
 
 		/* [P3-2] VM_TYPE에 따른 initializer 선택 */
 		vm_initializer *inner_init = NULL;
@@ -82,10 +108,12 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 		p->writable = writable; // [P3-2] 새 페이지의 writable 속성 설정
 		if(!spt_insert_page(spt, p)) goto err; // [P3-2] SPT에 페이지 삽입
 
+		spt_unlock (spt, taken);
 		return true;
 	}
 err: // [P3-2] 오류 발생시 페이지 메모리 해제 후 false 반환
-	free(p);
+	spt_unlock (spt, taken);
+	kmem_cache_free(vm_page_cache, p);
 	return false;
 }
 
@@ -96,9 +124,11 @@ spt_find_page (struct supplemental_page_table *spt UNUSED, void *va UNUSED) {
 
 	struct page p;
     struct hash_elem *e;
+	int taken = spt_lock (spt, false);
 
     p.va = pg_round_down(va);  // [P3-2] 페이지의 시작 주소로 VA 맞추기
     e = hash_find(&spt->hash, &p.hash_elem);
+	spt_unlock (spt, taken);
 
 	if(e == NULL) return NULL; // [P3-2] 페이지를 못 찾은 경우
 	else return hash_entry(e, struct page, hash_elem);
@@ -109,15 +139,20 @@ bool
 spt_insert_page (struct supplemental_page_table *spt UNUSED,
 		struct page *page UNUSED) {
 	/* [P3-2] SPT에서 페이지 삽입 */
+	int taken = spt_lock (spt, false);
+	bool success = hash_insert(&spt->hash, &page->hash_elem) == NULL; // [P3-2] 삽입 성공시 hash_insert()가 NULL 반환
 
-	if(hash_insert(&spt->hash, &page->hash_elem) == NULL) return true; // [P3-2] 삽입 성공시 hash_insert()가 NULL 반환
-	else return false;
+	spt_unlock (spt, taken);
+	return success;
 
 }
 
 void
 spt_remove_page (struct supplemental_page_table *spt, struct page *page) {
+	int taken = spt_lock (spt, false);
+
 	hash_delete(&spt->hash, &page->hash_elem);  // [P3-2] SPT에서 페이지 제거
+	spt_unlock (spt, taken);
 	vm_dealloc_page(page);  // [P3-2] 페이지 할당 해제
 	// TODO: frame 관련 처리?
 }
@@ -180,7 +215,7 @@ static struct frame *
 vm_get_frame (void) {
 	/* [P3-2] User pool에서 새로운 Physical Page를 가져오는 함수 */
 	void *kva = palloc_get_page(PAL_USER | PAL_ZERO); // [P3-2] User pool에서 0으로 초기화된 페이지 할당
-	struct frame *frame = malloc(sizeof *frame); // [P3-2] 프레임 할당
+	struct frame *frame = kmem_cache_alloc(frame_cache); // [P3-2] 프레임 할당
 
 	// msg("get frame: frame %p, kva %p", frame, kva);
     if(frame == NULL) PANIC("Failed to allocate struct frame"); // [P3-2] 프레임 할당 실패
@@ -212,7 +247,7 @@ vm_stack_growth (void *addr) {
 	for(void *p = fault_addr; p < USER_STACK; p += PGSIZE){
 		if(p < USER_STACK - (1 << 20)) break; // [P3-3] 1MB 스택 제한을 넘는 경우 확장 중단
 
-		if(spt_find_page(&thread_current()->spt, p) == NULL){ // [P3-3] 해당 주소에 페이지가 존재하지 않는 경우에만 할당
+		if(spt_find_page(&thread_current()->leader->spt, p) == NULL){ // [P3-3] 해당 주소에 페이지가 존재하지 않는 경우에만 할당
 			if(vm_alloc_page_with_initializer(VM_ANON | VM_MARKER_0, p, true, NULL, NULL)){ // [P3-3] anonymous + stack 마커 플래그 설정
 				vm_claim_page(p); // [P3-3] 바로 클레임
 			}
@@ -229,15 +264,29 @@ vm_handle_wp (struct page *page UNUSED) {
 bool
 vm_try_handle_fault (struct intr_frame *f, void *addr,
     bool user, bool write, bool not_present) {
-	struct supplemental_page_table *spt = &thread_current ()->spt;
+	struct supplemental_page_table *spt = &thread_current ()->leader->spt;
+	bool success;
+	int taken;
+
+	if(addr == NULL || is_kernel_vaddr(addr)) return false; // [P3-3] kernel 영역이거나 주소가 NULL인 경우 false 반환
+
+	/* 같은 페이지에 동시에 fault를 낸 스레드가 둘 다 클레임하지 않게 */
+	taken = spt_lock (spt, true);
+	success = handle_fault (spt, f, addr, user, write, not_present);
+	spt_unlock (spt, taken);
+	return success;
+}
+
+/* Does the work of vm_try_handle_fault(), with SPT locked. */
+static bool
+handle_fault (struct supplemental_page_table *spt, struct intr_frame *f,
+		void *addr, bool user, bool write, bool not_present) {
 	struct page *page = NULL;
 	/* TODO: Validate the fault */
 	/* TODO: Your code goes here */
 
-	if(addr == NULL || is_kernel_vaddr(addr)) return false; // [P3-3] kernel 영역이거나 주소가 NULL인 경우 false 반환
-
 	if(!not_present){ // [P3-3] 존재하는 페이지에 접근하는 경우
-		page = spt_find_page(&thread_current()->spt, addr);
+		page = spt_find_page(spt, addr);
 		if (page == NULL || (write && !page->writable)) return false; // [P3-3] 페이지를 찾을 수 없거나, 쓰기 권한이 없는 경우
 		return vm_do_claim_page(page); // [P3-3] 페이지 클레임 성공 여부 반환
 	}
@@ -257,6 +306,7 @@ vm_try_handle_fault (struct intr_frame *f, void *addr,
 		page = spt_find_page(spt, addr); // [P3-3] 방금 growth한 페이지 구조체를 SPT에서 찾기
 		if(page == NULL) return false; // [P3-3] 페이지 찾기 실패시 false 반환
 		if(write && !page->writable) return false; // 페이지에 쓰려는데 쓰기 권한이 없는 경우 false 반환
+		if(is_claimed(page)) return true; // 기다리는 동안 다른 스레드가 올린 페이지
 
 		return vm_do_claim_page(page); // [P3-3] 페이지 클레임 성공 여부 반환
 	}
@@ -267,7 +317,7 @@ vm_try_handle_fault (struct intr_frame *f, void *addr,
 void
 vm_dealloc_page (struct page *page) {
 	destroy (page);
-	free (page);
+	kmem_cache_free (vm_page_cache, page);
 }
 
 /* Claim the page that allocate on VA. */
@@ -275,9 +325,16 @@ bool
 vm_claim_page (void *va UNUSED) {
 	/* [P3-2] VA에 할당된 페이지를 요청하는 함수 */
 
-	struct page *page = spt_find_page(&thread_current ()->spt, va); // [P3-2] 페이지 할당
-    if(page == NULL) return false; // [P3-2] 해당 주소에 대한 페이지가 없는 경우 false
-    return vm_do_claim_page(page); // [P3-2] 실제 할당 수행
+	struct supplemental_page_table *spt = &thread_current ()->leader->spt;
+	int taken = spt_lock (spt, true);
+	struct page *page = spt_find_page(spt, va); // [P3-2] 페이지 할당
+	bool success;
+
+    if(page == NULL) success = false; // [P3-2] 해당 주소에 대한 페이지가 없는 경우 false
+	else if(is_claimed(page)) success = true; // 같은 프로세스의 다른 스레드가 이미 올린 페이지
+    else success = vm_do_claim_page(page); // [P3-2] 실제 할당 수행
+	spt_unlock (spt, taken);
+	return success;
 }
 
 /* Claim the PAGE and set up the mmu. */
@@ -315,6 +372,40 @@ bool page_less(const struct hash_elem *a, const struct hash_elem *b, void *aux U
 void
 supplemental_page_table_init (struct supplemental_page_table *spt) {
 	hash_init(&spt->hash, page_hash, page_less, NULL); // [P3-2] SPT 해시로 초기화
+	lock_init(&spt->lock);
+}
+
+/* Locks SPT for the current thread and returns the locks taken,
+   for spt_unlock().  Threads made by clone() share their process's
+   SPT, so lookups and changes are done under its lock, and so are
+   page claims, so that two threads faulting on one page do not
+   both claim it.  A claim may take the file lock under the SPT
+   lock, while mmap() and munmap() change the SPT under the file
+   lock, so with CLAIM, a process with more than one thread takes
+   the file lock first.  Locks already held are not taken again. */
+static int
+spt_lock (struct supplemental_page_table *spt, bool claim) {
+	int taken = 0;
+
+	if (claim && thread_current ()->leader->thread_cnt > 1
+			&& !process_file_held ()) {
+		process_lock_file_read ();
+		taken |= SPT_LOCKED_FILE;
+	}
+	if (!lock_held_by_current_thread (&spt->lock)) {
+		lock_acquire (&spt->lock);
+		taken |= SPT_LOCKED_SPT;
+	}
+	return taken;
+}
+
+/* Releases the locks TAKEN by spt_lock(). */
+static void
+spt_unlock (struct supplemental_page_table *spt, int taken) {
+	if (taken & SPT_LOCKED_SPT)
+		lock_release (&spt->lock);
+	if (taken & SPT_LOCKED_FILE)
+		process_release_file ();
 }
 
 /* Copy supplemental page table from src to	 dst */
@@ -341,12 +432,12 @@ supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 		
 				/* [P3-2] lazy exec/file segment인 경우 aux 구조체 깊은 복사 */
 				if(src_aux != NULL && src_aux->file != NULL){
-					struct segment_aux *dst_aux = malloc(sizeof(struct segment_aux)); // [P3-2] 새 aux 구조체 할당
+					struct segment_aux *dst_aux = kmem_cache_alloc(segment_aux_cache); // [P3-2] 새 aux 구조체 할당
 					if(dst_aux == NULL) return false; // [P3-2] 메모리 할당 실패시 false 반환
 		
 					dst_aux->file = file_reopen(src_aux->file); // [P3-2] file 포인터를 복사해 독립적으로 참조
 					if(dst_aux->file == NULL){ // [P3-2] reopen 실패 시 메모리 해제 후 false 반환
-						free(dst_aux);
+						kmem_cache_free(segment_aux_cache, dst_aux);
 						return false;
 					}
 					
@@ -358,7 +449,7 @@ supplemental_page_table_copy (struct supplemental_page_table *dst UNUSED,
 					
 					/* [P3-2] 자식 SPT에 복사된 페이지 등록 후 aux 구조체 메모리 해제 */
 					if(!vm_alloc_page_with_initializer(u->type, va, writable, u->init, dst_aux)){
-						free(dst_aux);
+						kmem_cache_free(segment_aux_cache, dst_aux);
 						return false;
 					}
 				}